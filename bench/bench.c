@@ -0,0 +1,232 @@
+// microbenchmark ของเส้นทางวาด/ส่ง OLED บนเครื่องไหนก็ได้ (I2C ใช้ backend จำลอง i2c_mem.c)
+//
+//   make bench && ./build/bench [-c bus_hz] [-t ms] [font.ttf]
+//
+// รายงาน ns/op และ byte/transaction บนบัสต่อ op เพื่อดู regression
+// -c จำลองความเร็วบัส (เช่น 400000) ให้ time/frame ใกล้ของจริง ไม่ระบุ = วัดเฉพาะ CPU
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "oled_i2c.h"
+#include "font.h"
+#include "scene.h"
+#include "i2c_mem.h"
+
+#define BENCH_PANELS 4
+
+static int bench_ms = 200;
+static uint32_t bus_hz;
+static oled_t *oled;                    // จอหลัก 128x64 (เหมือน monitor_control)
+static i2c_bus_t *oled_bus;
+// จอที่ op ชุดปัจจุบันใช้: run() รอให้ทุกจอส่งเสร็จและรวมสถิติบัสของทุกจอ
+static oled_t *panels[BENCH_PANELS];
+static i2c_bus_t *buses[BENCH_PANELS];
+static int npanels;
+
+static uint64_t now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint64_t)ts.tv_sec*1000000000u+ts.tv_nsec;
+}
+
+// เรียก op ซ้ำจนครบ bench_ms (ครั้งละเป็นชุด เพื่อไม่ให้เวลาอ่านนาฬิกากลบ op ที่เร็วมาก)
+static void sync_all(void){
+    for(int i=0;i<npanels;i++) oled_sync(panels[i]);
+}
+
+static void bus_stats(i2c_mem_stats_t *st){
+    memset(st,0,sizeof(*st));
+    for(int i=0;i<npanels;i++){
+        i2c_mem_stats_t s;
+        i2c_mem_get_stats(buses[i],&s);
+        st->bytes+=s.bytes;
+        st->transactions+=s.transactions;
+    }
+}
+
+static void run(const char *name,void (*op)(void *arg),void *arg){
+    i2c_mem_stats_t s0,s1;
+    op(arg);                                // warm-up (glyph cache, shadow ของ OLED)
+    sync_all();
+    bus_stats(&s0);
+
+    uint64_t n=0,batch=1,start=now_ns(),elapsed;
+    do {
+        for(uint64_t i=0;i<batch;i++) op(arg);
+        n+=batch;
+        elapsed=now_ns()-start;
+        if(elapsed<(uint64_t)bench_ms*1000000/10) batch*=2;
+    } while(elapsed<(uint64_t)bench_ms*1000000);
+    sync_all();
+    elapsed=now_ns()-start;
+    bus_stats(&s1);
+
+    // printf นับความกว้างเป็น byte ชดเชยให้ชื่อภาษาไทย (UTF-8 ตัวละ 3 byte) ตรงคอลัมน์
+    int pad=40;
+    for(const char *c=name;*c;c++) if((*c&0xc0)==0x80) pad++;
+    printf("%-*s %12.1f ns/op %9.1f B/op %7.2f xfer/op\n",pad,name,(double)elapsed/n,
+           (double)(s1.bytes-s0.bytes)/n,(double)(s1.transactions-s0.transactions)/n);
+}
+
+struct text_arg { const char *text; int size; };
+
+static void op_render_text(void *arg){
+    struct text_arg *t=arg;
+    render_text(oled,t->text,0,40,t->size);
+}
+
+static void op_clear_line(void *arg){ (void)arg; oled_clear_line(oled,16,24); }
+static void op_fill_rect(void *arg){ (void)arg; oled_fill_rect(oled,3,5,100,21,1); }
+static void op_invert_rect(void *arg){ (void)arg; oled_invert_rect(oled,0,0,128,64); }
+static void op_draw_pixel(void *arg){
+    (void)arg;
+    for(int x=0;x<128;x++) oled_draw_pixel(oled,x,x/2,1);
+}
+
+static uint8_t blit_bits[24*3];
+static void op_blit(void *arg){ (void)arg; oled_blit(oled,10,5,blit_bits,24,24); }
+
+// frame ทั้งจอเปลี่ยน: ส่งทุก page
+static void op_display_full(void *arg){
+    (void)arg;
+    oled_invert_rect(oled,0,0,128,64);
+    oled_display(oled);
+    oled_sync(oled);
+}
+
+// เปลี่ยนหนึ่งบรรทัดข้อความ (สูง 24 px)
+static void op_display_line(void *arg){
+    (void)arg;
+    oled_invert_rect(oled,0,36,128,24);
+    oled_display(oled);
+    oled_sync(oled);
+}
+
+// เปลี่ยนเล็กน้อย (ตัวเลขหนึ่งตัว)
+static void op_display_small(void *arg){
+    (void)arg;
+    oled_invert_rect(oled,100,8,12,16);
+    oled_display(oled);
+    oled_sync(oled);
+}
+
+static void op_display_nochange(void *arg){
+    (void)arg;
+    oled_display(oled);
+    oled_sync(oled);
+}
+
+// เส้นทางเดียวกับ render_monitor_text() ใน monitor_control.c: ตั้งสอง region แล้วรอจนถึงจอ
+static void op_monitor_text(void *arg){
+    static int flip;
+    (void)arg;
+    flip=!flip;
+    scene_set_text(SCENE_HEADER,flip?"หน้าจอ: 1":"หน้าจอ: 2",24);
+    scene_set_text(SCENE_STATUS,flip?"เชื่อมต่อ":"ทำรายการ",24);
+    scene_cancel_overlay(SCENE_HEADER);
+    scene_cancel_overlay(SCENE_STATUS);
+    oled_sync(oled);
+}
+
+// ข้อความตอบรับปุ่ม (show_action): overlay แล้วกลับเป็นข้อความหลัก
+static void op_overlay(void *arg){
+    (void)arg;
+    scene_overlay(SCENE_STATUS,"ขึ้น",24,1000);
+    scene_cancel_overlay(SCENE_STATUS);
+    oled_sync(oled);
+}
+
+// ทุกจอเปลี่ยนทั้งจอพร้อมกันแล้วรอจนถึงจอครบ (op = หนึ่งรอบของทุกจอ)
+static void op_panels_full(void *arg){
+    (void)arg;
+    for(int i=0;i<npanels;i++){
+        oled_invert_rect(panels[i],0,0,oled_width(panels[i]),oled_height(panels[i]));
+        oled_display(panels[i]);
+    }
+    sync_all();
+}
+
+// n จอ ขนาด 128xheight บนบัสแยกกัน (shared=0) หรือบัสเดียวกันคนละ address (shared=1)
+// บัสแยก: เวลาต่อรอบควรใกล้จอเดียวเมื่อจำลอง clock (-c) บัสเดียวกัน: โตตามจำนวนจอ
+static void run_panels(const char *name,int n,int shared,int height){
+    for(int i=0;i<n;i++){
+        char path[32];
+        snprintf(path,sizeof(path),"/dev/i2c-%d",shared?1:1+i);
+        if(!(panels[i]=oled_open(path,OLED_ADDR+(shared?i:0),128,height))) exit(1);
+        buses[i]=i2c_mem_last();
+        i2c_mem_set_clock(buses[i],bus_hz);
+    }
+    npanels=n;
+    run(name,op_panels_full,NULL);
+    for(int i=0;i<n;i++) oled_close(panels[i]);
+
+    panels[0]=oled;
+    buses[0]=oled_bus;
+    npanels=1;
+}
+
+int main(int argc,char **argv){
+    const char *font=getenv("BENCH_FONT");
+    int opt;
+    while((opt=getopt(argc,argv,"c:t:"))!=-1){
+        if(opt=='c') bus_hz=strtoul(optarg,NULL,10);
+        else if(opt=='t') bench_ms=atoi(optarg);
+        else { fprintf(stderr,"usage: %s [-c bus_hz] [-t ms] [font.ttf]\n",argv[0]); return 2; }
+    }
+    if(optind<argc) font=argv[optind];
+    if(!font) font="./fonts/NotoSerifThai.ttf";
+
+    if(!(oled=oled_open(OLED_BUS,OLED_ADDR,128,64))) return 1;
+    oled_bus=i2c_mem_last();
+    i2c_mem_set_clock(oled_bus,bus_hz);
+    panels[0]=oled;
+    buses[0]=oled_bus;
+    npanels=1;
+    int have_font=font_init(font)==0;
+    for(size_t i=0;i<sizeof(blit_bits);i++) blit_bits[i]=(uint8_t)(i*37);
+
+    printf("bus %s, font %s\n",bus_hz?"simulated":"unthrottled",have_font?font:"(none)");
+
+    if(have_font){
+        static const char *texts[]={ "หน้าจอ: 1", "เชื่อมต่อ", "192.168.100.200", "Shutdown" };
+        static const int sizes[]={ 24, 18 };
+        struct text_arg args[8];
+        char name[64];
+        int k=0;
+        for(size_t s=0;s<2;s++)
+            for(size_t i=0;i<4;i++,k++){
+                args[k]=(struct text_arg){ texts[i], sizes[s] };
+                snprintf(name,sizeof(name),"render_text/%d/%s",sizes[s],texts[i]);
+                run(name,op_render_text,&args[k]);
+            }
+    }
+
+    run("oled_clear_line/24",op_clear_line,NULL);
+    run("oled_fill_rect/100x21",op_fill_rect,NULL);
+    run("oled_invert_rect/full",op_invert_rect,NULL);
+    run("oled_draw_pixel/x128",op_draw_pixel,NULL);
+    run("oled_blit/24x24",op_blit,NULL);
+
+    run("oled_display/full",op_display_full,NULL);
+    run("oled_display/line",op_display_line,NULL);
+    run("oled_display/small",op_display_small,NULL);
+    run("oled_display/nochange",op_display_nochange,NULL);
+
+    run_panels("panels/1x128x32",1,0,32);
+    run_panels("panels/2 buses",2,0,64);
+    run_panels("panels/4 buses",4,0,64);
+    run_panels("panels/2 same bus",2,1,64);
+
+    if(have_font){
+        scene_init(oled);
+        run("render_monitor_text",op_monitor_text,NULL);
+        run("scene_overlay+cancel",op_overlay,NULL);
+    }
+
+    oled_close(oled);
+    font_done();
+    return 0;
+}
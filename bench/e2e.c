@@ -0,0 +1,773 @@
+// e2e: รัน monitor_control ตัวจริงแล้ววัดเวลาตั้งแต่ขอบสัญญาณของปุ่มจนถึง
+//   - datagram คำสั่งถึง monitor (press -> packet)
+//   - ภาพบน OLED เปลี่ยน (press -> oled, จอเสมือนของ i2c_mem.c)
+//
+//   make e2e
+//   ./build/e2e -f fonts/NotoSerifThai.ttf [-p ascii|bin] [-d ms] [-l %] [-L %] [-n rounds] [-s script]
+//
+//   -b path   monitor_control ที่ build ด้วย I2C=mem (ค่าเริ่มต้น build/mock/monitor_control)
+//   -p        โปรโตคอลของ monitor ทุกตัว
+//   -d / -l   stub ตอบ pong/ack ช้าไป ms / ไม่ตอบ ping กี่ %
+//   -L        ทิ้ง datagram คำสั่งที่เข้ามากี่ % (ดูการส่งซ้ำของแบบ bin)
+//   -c hz     จำลองความเร็วบัส I2C (I2C_MEM_CLOCK) เช่น 400000
+//   -g ms     เว้นระหว่างขั้นของ script (ค่าเริ่มต้น 300)
+//   -G dir    ใช้ gpio-sim ของ kernel แทน GPIO จำลอง: dir = /sys/devices/platform/gpio-sim.0/gpiochipN
+//             (binary ต้อง build ด้วย GPIO=gpiod, ใส่ชื่อ chip ด้วย -C gpiochipN)
+//   -k        เก็บ directory ทำงาน (.env, log, events.bin, ภาพ OLED ของแต่ละขั้นเป็น .pbm)
+//
+// monitor ทั้ง NMON ตัวคือ stub ใน process นี้ที่ 127.0.0.1-8 ตอบ ping แบบ monitor จริงและ ack แบบ selective
+// ปุ่มเลือกได้แค่ 3 ตัวแรก ที่เหลือมีไว้ให้ health ping หลายตัวพร้อมกัน: ทุกตัวต้องขึ้น up (EV_HEALTH)
+// script: หนึ่งบรรทัดต่อขั้น "press KEY[+KEY...] [hold_ms] [gap_ms]" หรือ "wait ms" (# = comment)
+//   KEY = DO DOWN UP DONE MON1 MON2 MON3  กดหลายปุ่มในขั้นเดียว = ขอบสัญญาณพร้อมกัน
+//   ไม่ระบุ -s: เลือกจอ/ส่งคำสั่งวน -n รอบ แล้ว UP+DOWN ค้าง (แสดง IP) และ MON1+2+3 ค้าง (ปิดเครื่อง)
+//
+// คำสั่งที่ควรได้คำนวณจาก script (จอปัจจุบัน, ปุ่มที่กด) แล้วเทียบกับที่ stub ได้รับ: ขาด, เกิน,
+// seq ซ้ำ (แบบ bin) คืน 1 ถ้ามีคำสั่งขาด/เกิน หรือไม่เห็นเหตุการณ์แสดง IP/ปิดเครื่อง
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <poll.h>
+#include <signal.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "proto.h"
+#include "evlog.h"
+#include "i2c_mem.h"
+
+#define NMON 8             // 3 ตัวแรกมีปุ่ม MON1-3
+#define HOLD_MS 3000            // ตรงกับ monitor_control.c
+#define REPEAT_DELAY_MS 400
+#define MAX_PENDING 256
+
+// ลำดับเดียวกับ inputs[] ใน monitor_control.c (evlog เก็บ index นี้ใน arg ของ EV_PRESS)
+enum { K_DO, K_DOWN, K_UP, K_DONE, K_MON1, K_MON2, K_MON3, NKEYS };
+static const struct { const char *name; unsigned offset; int active; int cmd; } keys[NKEYS] = {
+    [K_DO]   = { "DO",   6,  0, PROTO_DO },
+    [K_DOWN] = { "DOWN", 21, 1, PROTO_DOWN },
+    [K_UP]   = { "UP",   20, 1, PROTO_UP },
+    [K_DONE] = { "DONE", 17, 1, PROTO_DONE },
+    [K_MON1] = { "MON1", 7,  0, PROTO_SELECT },
+    [K_MON2] = { "MON2", 8,  0, PROTO_SELECT },
+    [K_MON3] = { "MON3", 9,  0, PROTO_SELECT },
+};
+#define MON_KEYS ((1<<K_MON1)|(1<<K_MON2)|(1<<K_MON3))
+#define CMD_KEYS ((1<<K_DO)|(1<<K_DOWN)|(1<<K_UP)|(1<<K_DONE))
+
+typedef struct { int monitor, cmd, count; uint64_t ts; int matched; } expect_t;
+
+typedef struct {
+    int keys, hold_ms, gap_ms;
+    uint64_t inject, release;
+    int checked;                // ขั้นที่ผสม MON + ปุ่มคำสั่ง ลำดับ edge ไม่แน่นอน ไม่ตรวจคำสั่ง
+    int repeat;                 // UP/DOWN ค้างนานพอจะส่งซ้ำ: ต้องได้อย่างน้อยหนึ่ง ไม่นับที่เกิน
+    int combo, shutdown;
+    expect_t exp[NKEYS];
+    int nexp;
+    int extra;
+} step_t;
+
+typedef struct { uint64_t ts; int monitor, cmd, count, dup; uint32_t seq; } rx_t;
+
+static step_t *steps;
+static int nsteps;
+
+// ---- ตัวเลือก ----
+static const char *binary = "build/mock/monitor_control";
+static const char *font;
+static const char *script;
+static const char *sim_dir;
+static const char *sim_chip;
+static int use_bin, ping_delay_ms, ping_loss, cmd_loss, rounds = 5, gap_ms = 300, keep;
+static unsigned bus_hz;
+static int port = 15000;
+
+static char workdir[64];
+static pid_t child = -1;
+static int ctl_fd = -1;
+static struct sockaddr_un ctl_addr;
+
+// ---- ข้อมูลที่ thread รับบันทึก (ป้องกันด้วย lock) ----
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static rx_t *rx;
+static int nrx, rx_cap;
+static uint64_t *changes;       // เวลาที่ภาพบน OLED เปลี่ยน (จาก i2c_mem)
+static int nchanges, changes_cap;
+static uint8_t frame[I2C_MEM_PAGES*I2C_MEM_WIDTH];
+static uint32_t frames, frames_lost, last_seq;
+static unsigned pings[NMON], pongs[NMON], pings_dropped, cmds_dropped;
+static atomic_int running = 1;
+
+static int mon_fd[NMON];
+static int cap_fd = -1;
+static uint32_t ack_cum[NMON], ack_bits[NMON];
+
+struct pending { uint64_t due; int fd; struct sockaddr_in to; uint8_t buf[32]; int len; };
+static struct pending pending[MAX_PENDING];
+static int npending;
+
+static uint64_t now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint64_t)ts.tv_sec*1000000000u+ts.tv_nsec;
+}
+
+static void sleep_until(uint64_t t){
+    struct timespec ts={ (time_t)(t/1000000000u), (long)(t%1000000000u) };
+    while(clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&ts,NULL)==EINTR)
+        ;
+}
+
+static void *grow(void *p,int *cap,int n,size_t size){
+    if(n<*cap) return p;
+    *cap=*cap ? *cap*2 : 256;
+    p=realloc(p,*cap*size);
+    if(!p){ perror("realloc"); exit(1); }
+    return p;
+}
+
+// ---- monitor stub ----
+
+static void reply(int fd,const struct sockaddr_in *to,const void *buf,int len){
+    if(!ping_delay_ms){
+        sendto(fd,buf,len,0,(const struct sockaddr*)to,sizeof(*to));
+        return;
+    }
+    if(npending==MAX_PENDING) return;
+    struct pending *p=&pending[npending++];
+    p->due=now_ns()+(uint64_t)ping_delay_ms*1000000;
+    p->fd=fd;
+    p->to=*to;
+    memcpy(p->buf,buf,len);
+    p->len=len;
+}
+
+static void send_due(uint64_t now){
+    for(int i=0;i<npending;){
+        if(pending[i].due>now){ i++; continue; }
+        sendto(pending[i].fd,pending[i].buf,pending[i].len,0,(struct sockaddr*)&pending[i].to,sizeof(pending[i].to));
+        pending[i]=pending[--npending];
+    }
+}
+
+static int chance(int pct){ return pct>0 && rand()%100<pct; }
+
+static void record(int m,int cmd,int count,uint32_t seq,int dup,uint64_t ts){
+    pthread_mutex_lock(&lock);
+    rx=grow(rx,&rx_cap,nrx,sizeof(*rx));
+    rx[nrx++]=(rx_t){ ts, m, cmd, count, dup, seq };
+    pthread_mutex_unlock(&lock);
+}
+
+// frame แบบ bin: บันทึก แล้ว ack สะสม + bitmap ของ seq ที่ได้ข้ามมา (เหมือน monitor จริง)
+static void on_frame(int m,const uint8_t *b,const struct sockaddr_in *from,uint64_t ts){
+    uint32_t seq=(uint32_t)b[4]<<24|b[5]<<16|b[6]<<8|b[7];
+    int32_t k=(int32_t)(seq-ack_cum[m]-1);
+    int dup=k<0 || (k<32 && (ack_bits[m]>>k&1));
+    record(m,b[2],b[3],seq,dup,ts);
+    if(!dup && k<32){
+        ack_bits[m]|=1u<<k;
+        while(ack_bits[m]&1){ ack_cum[m]++; ack_bits[m]>>=1; }
+    }
+    uint8_t a[PROTO_ACK_LEN]={ PROTO_MAGIC, PROTO_VERSION, PROTO_ACK, 0,
+        ack_cum[m]>>24, ack_cum[m]>>16, ack_cum[m]>>8, ack_cum[m],
+        ack_bits[m]>>24, ack_bits[m]>>16, ack_bits[m]>>8, ack_bits[m],
+        b[8], b[9], b[10], b[11] };
+    reply(mon_fd[m],from,a,sizeof(a));
+}
+
+static void on_monitor(int m){
+    uint8_t buf[64];
+    struct sockaddr_in from;
+    socklen_t len=sizeof(from);
+    ssize_t n=recvfrom(mon_fd[m],buf,sizeof(buf)-1,MSG_DONTWAIT,(struct sockaddr*)&from,&len);
+    uint64_t ts=now_ns();
+    if(n<=0) return;
+    buf[n]=0;
+
+    if(n>=4 && memcmp(buf,"ping",4)==0){
+        pthread_mutex_lock(&lock);
+        pings[m]++;
+        int drop=chance(ping_loss);
+        if(drop) pings_dropped++;
+        else pongs[m]++;
+        pthread_mutex_unlock(&lock);
+        if(!drop){
+            buf[1]='o';                     // "ping <seq>" -> "pong <seq>"
+            reply(mon_fd[m],&from,buf,n);
+        }
+        return;
+    }
+    if(chance(cmd_loss)){
+        pthread_mutex_lock(&lock);
+        cmds_dropped++;
+        pthread_mutex_unlock(&lock);
+        return;
+    }
+    if(n==PROTO_FRAME_LEN && buf[0]==PROTO_MAGIC){ on_frame(m,buf,&from,ts); return; }
+
+    static const char *text[] = { [PROTO_DO]="do", [PROTO_UP]="up", [PROTO_DOWN]="down", [PROTO_DONE]="done" };
+    for(int c=PROTO_DO;c<=PROTO_DONE;c++)
+        if(strcmp((char*)buf,text[c])==0){ record(m,c,1,0,0,ts); return; }
+    if(buf[0]=='m'){ record(m,PROTO_SELECT,atoi((char*)buf+1),0,0,ts); return; }
+    fprintf(stderr,"monitor%d: unknown datagram \"%s\"\n",m+1,buf);
+}
+
+static void on_capture(void){
+    i2c_mem_frame_t f;
+    ssize_t n=recv(cap_fd,&f,sizeof(f),MSG_DONTWAIT);
+    if(n!=sizeof(f) || memcmp(f.magic,I2C_MEM_FRAME_MAGIC,4)!=0) return;
+    pthread_mutex_lock(&lock);
+    if(last_seq && f.seq!=last_seq+1) frames_lost+=f.seq-last_seq-1;
+    last_seq=f.seq;
+    frames++;
+    if(memcmp(frame,f.gddram,sizeof(frame))!=0){
+        memcpy(frame,f.gddram,sizeof(frame));
+        changes=grow(changes,&changes_cap,nchanges,sizeof(*changes));
+        changes[nchanges++]=f.ts;
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+static void *stub_main(void *arg){
+    (void)arg;
+    struct pollfd p[NMON+1];
+    for(int m=0;m<NMON;m++) p[m]=(struct pollfd){ mon_fd[m], POLLIN, 0 };
+    p[NMON]=(struct pollfd){ cap_fd, POLLIN, 0 };
+    while(atomic_load(&running)){
+        int timeout=50;
+        uint64_t now=now_ns();
+        for(int i=0;i<npending;i++){
+            int ms=pending[i].due>now ? (int)((pending[i].due-now+999999)/1000000) : 0;
+            if(ms<timeout) timeout=ms;
+        }
+        if(poll(p,NMON+1,timeout)<0 && errno!=EINTR){ perror("poll"); break; }
+        for(int m=0;m<NMON;m++) if(p[m].revents&POLLIN) on_monitor(m);
+        if(p[NMON].revents&POLLIN) on_capture();
+        send_due(now_ns());
+    }
+    return NULL;
+}
+
+static int open_sockets(void){
+    for(int m=0;m<NMON;m++){
+        struct sockaddr_in a={ .sin_family=AF_INET, .sin_port=htons(port) };
+        a.sin_addr.s_addr=htonl(0x7f000001+m);     // 127.0.0.1-8
+        mon_fd[m]=socket(AF_INET,SOCK_DGRAM|SOCK_CLOEXEC,0);
+        if(mon_fd[m]<0 || bind(mon_fd[m],(struct sockaddr*)&a,sizeof(a))<0){ perror("monitor stub bind"); return -1; }
+    }
+    struct sockaddr_un a={ .sun_family=AF_UNIX };
+    snprintf(a.sun_path,sizeof(a.sun_path),"%s/oled.sock",workdir);
+    cap_fd=socket(AF_UNIX,SOCK_DGRAM|SOCK_CLOEXEC,0);
+    if(cap_fd<0 || bind(cap_fd,(struct sockaddr*)&a,sizeof(a))<0){ perror("capture bind"); return -1; }
+    int rcv=4<<20;
+    setsockopt(cap_fd,SOL_SOCKET,SO_RCVBUF,&rcv,sizeof(rcv));
+
+    ctl_addr.sun_family=AF_UNIX;
+    snprintf(ctl_addr.sun_path,sizeof(ctl_addr.sun_path),"%s/gpio.sock",workdir);
+    ctl_fd=socket(AF_UNIX,SOCK_DGRAM|SOCK_CLOEXEC,0);
+    return ctl_fd<0 ? -1 : 0;
+}
+
+// ---- ปุ่ม ----
+
+static int sim_write(unsigned offset,int value){
+    char path[256];
+    snprintf(path,sizeof(path),"%s/sim_gpio%u/pull",sim_dir,offset);
+    int fd=open(path,O_WRONLY|O_CLOEXEC);
+    if(fd<0){ perror(path); return -1; }
+    const char *v=value ? "pull-up" : "pull-down";
+    int r=write(fd,v,strlen(v))<0 ? -1 : 0;
+    close(fd);
+    return r;
+}
+
+// ตั้งปุ่มใน mask เป็นกด/ปล่อยพร้อมกัน คืนเวลาก่อนส่ง (จุดเริ่มของ latency)
+static uint64_t inject(int mask,int down){
+    uint64_t t=now_ns();
+    if(sim_dir){
+        for(int k=0;k<NKEYS;k++)
+            if(mask>>k&1) sim_write(keys[k].offset,down ? keys[k].active : !keys[k].active);
+        return t;
+    }
+    char msg[128];
+    int n=0;
+    for(int k=0;k<NKEYS;k++)
+        if(mask>>k&1) n+=snprintf(msg+n,sizeof(msg)-n,"%s%u=%d",n?",":"",keys[k].offset,down ? keys[k].active : !keys[k].active);
+    if(sendto(ctl_fd,msg,n,0,(struct sockaddr*)&ctl_addr,sizeof(ctl_addr))<0) perror("gpio inject");
+    return t;
+}
+
+// ---- script ----
+
+static int parse_keys(const char *s){
+    int mask=0;
+    char buf[128];
+    snprintf(buf,sizeof(buf),"%s",s);
+    for(char *save,*t=strtok_r(buf,"+",&save);t;t=strtok_r(NULL,"+",&save)){
+        int k;
+        for(k=0;k<NKEYS && strcasecmp(t,keys[k].name)!=0;k++)
+            ;
+        if(k==NKEYS){ fprintf(stderr,"unknown key %s\n",t); return -1; }
+        mask|=1<<k;
+    }
+    return mask;
+}
+
+static void add_step(int mask,int hold,int gap){
+    static int cap;
+    steps=grow(steps,&cap,nsteps,sizeof(*steps));
+    steps[nsteps++]=(step_t){ .keys=mask, .hold_ms=hold, .gap_ms=gap };
+}
+
+static int parse_line(char *line){
+    char *cmd=strtok(line," \t\r\n");
+    if(!cmd || cmd[0]=='#') return 0;
+    char *a=strtok(NULL," \t\r\n"), *b=strtok(NULL," \t\r\n"), *c=strtok(NULL," \t\r\n");
+    if(strcmp(cmd,"wait")==0 && a){ add_step(0,0,atoi(a)); return 0; }
+    if(strcmp(cmd,"press")!=0 || !a) return -1;
+    int mask=parse_keys(a);
+    if(mask<=0) return -1;
+    add_step(mask,b?atoi(b):80,c?atoi(c):gap_ms);
+    return 0;
+}
+
+static int load_script(void){
+    if(!script){
+        static const char *body[] = { "MON1","DO","UP","DOWN","DONE","MON2","DO","MON3","UP","MON1" };
+        for(int r=0;r<rounds;r++)
+            for(size_t i=0;i<sizeof(body)/sizeof(body[0]);i++) add_step(parse_keys(body[i]),80,gap_ms);
+        add_step(parse_keys("UP+DOWN"),HOLD_MS+300,gap_ms+700);
+        add_step(MON_KEYS,HOLD_MS+300,gap_ms);
+        return 0;
+    }
+    FILE *fp=fopen(script,"r");
+    if(!fp){ perror(script); return -1; }
+    char line[256];
+    int first=nsteps, lineno=0;
+    while(fgets(line,sizeof(line),fp)){
+        lineno++;
+        if(parse_line(line)<0){ fprintf(stderr,"%s:%d: bad step\n",script,lineno); fclose(fp); return -1; }
+    }
+    fclose(fp);
+    int n=nsteps-first;
+    for(int r=1;r<rounds;r++)
+        for(int i=0;i<n;i++) add_step(steps[first+i].keys,steps[first+i].hold_ms,steps[first+i].gap_ms);
+    return 0;
+}
+
+// คำสั่งที่ต้องได้จากแต่ละขั้น ตามพฤติกรรมของ on_input() (มี monitor 3 ตัว = หน้าเดียว ไม่มีกลุ่ม)
+static void plan(void){
+    int cur=0;
+    for(int i=0;i<nsteps;i++){
+        step_t *s=&steps[i];
+        int mon=s->keys&MON_KEYS, cmd=s->keys&CMD_KEYS;
+        s->checked=!(mon && cmd);
+        for(int k=K_MON1;k<=K_MON3;k++)
+            if(s->keys>>k&1){
+                s->exp[s->nexp++]=(expect_t){ k-K_MON1, PROTO_SELECT, k-K_MON1+1, 0, 0 };
+                cur=k-K_MON1;
+            }
+        if(mon==MON_KEYS){
+            if(s->hold_ms>=HOLD_MS) s->shutdown=1;
+            else cur=0;                     // ปล่อยก่อนครบเวลา: กลับไปจอ 1 (ไม่ส่งคำสั่ง)
+        }
+        if(!mon){
+            for(int k=K_DO;k<=K_DONE;k++)
+                if(s->keys>>k&1) s->exp[s->nexp++]=(expect_t){ cur, keys[k].cmd, 1, 0, 0 };
+            if(cmd==((1<<K_UP)|(1<<K_DOWN)) && s->hold_ms>=HOLD_MS) s->combo=1;
+            else if((cmd==1<<K_UP || cmd==1<<K_DOWN) && s->hold_ms>=REPEAT_DELAY_MS) s->repeat=1;
+        }
+    }
+}
+
+static int step_at(uint64_t ts){
+    int s=-1;
+    for(int i=0;i<nsteps && steps[i].inject && steps[i].inject<=ts;i++) s=i;
+    return s;
+}
+
+static int match(step_t *s,const rx_t *r){
+    for(int e=0;e<s->nexp;e++){
+        expect_t *x=&s->exp[e];
+        if(x->matched || x->monitor!=r->monitor || x->cmd!=r->cmd) continue;
+        if(x->cmd==PROTO_SELECT && x->count!=r->count) continue;
+        x->matched=1;
+        x->ts=r->ts;
+        return 1;
+    }
+    return 0;
+}
+
+// คำสั่งที่เข้ามาเป็นของขั้นล่าสุดที่เริ่มก่อนมัน (หรือขั้นก่อนหน้า เผื่อส่งซ้ำช้าข้ามขั้น)
+static void check(int *dups){
+    *dups=0;
+    for(int i=0;i<nrx;i++){
+        const rx_t *r=&rx[i];
+        if(r->dup){ (*dups)++; continue; }
+        int si=step_at(r->ts);
+        if(si<0){ fprintf(stderr,"monitor%d: command %d before first step\n",r->monitor+1,r->cmd); continue; }
+        step_t *s=&steps[si];
+        if(match(s,r) || (si>0 && match(&steps[si-1],r))) continue;
+        if(s->repeat && r->cmd!=PROTO_SELECT) continue;
+        s->extra++;
+    }
+}
+
+// ---- รายงาน ----
+
+static int cmp_u64(const void *a,const void *b){
+    uint64_t x=*(const uint64_t*)a, y=*(const uint64_t*)b;
+    return x<y ? -1 : x>y;
+}
+
+static void report(const char *name,uint64_t *v,int n){
+    printf("%-18s n %4d",name,n);
+    if(n){
+        qsort(v,n,sizeof(*v),cmp_u64);
+        uint64_t sum=0;
+        for(int i=0;i<n;i++) sum+=v[i];
+        printf("  mean %8.3f  p50 %8.3f  p90 %8.3f  p99 %8.3f  max %8.3f ms",
+               sum/(double)n/1e6,v[n/2]/1e6,v[(n*9)/10]/1e6,v[n*99/100]/1e6,v[n-1]/1e6);
+    }
+    putchar('\n');
+}
+
+// ภาพบนจอเปลี่ยนครั้งแรกหลัง t (ภายใน limit) คืน 0 ถ้าไม่เปลี่ยน
+static uint64_t first_change(uint64_t t,uint64_t limit){
+    for(int i=0;i<nchanges;i++) if(changes[i]>=t) return changes[i]<limit ? changes[i] : 0;
+    return 0;
+}
+
+static void write_pbm(const char *name){
+    char path[128];
+    snprintf(path,sizeof(path),"%s/%s",workdir,name);
+    FILE *fp=fopen(path,"w");
+    if(!fp) return;
+    fprintf(fp,"P1\n%d %d\n",I2C_MEM_WIDTH,I2C_MEM_PAGES*8);
+    pthread_mutex_lock(&lock);
+    for(int y=0;y<I2C_MEM_PAGES*8;y++){
+        for(int x=0;x<I2C_MEM_WIDTH;x++) fputc(frame[(y/8)*I2C_MEM_WIDTH+x]>>(y%8)&1 ? '1' : '0',fp);
+        fputc('\n',fp);
+    }
+    pthread_mutex_unlock(&lock);
+    fclose(fp);
+}
+
+static evlog_rec_t *read_events(int *n){
+    char path[128];
+    snprintf(path,sizeof(path),"%s/events.bin",workdir);
+    FILE *fp=fopen(path,"rb");
+    *n=0;
+    if(!fp) return NULL;
+    uint8_t hdr[8];
+    evlog_rec_t *ev=NULL;
+    int cap=0;
+    if(fread(hdr,1,sizeof(hdr),fp)==sizeof(hdr) && memcmp(hdr,EVLOG_MAGIC,4)==0 && hdr[5]==sizeof(evlog_rec_t)){
+        evlog_rec_t r;
+        while(fread(&r,sizeof(r),1,fp)==1){
+            ev=grow(ev,&cap,*n,sizeof(*ev));
+            ev[(*n)++]=r;
+        }
+    }
+    fclose(fp);
+    return ev;
+}
+
+static uint64_t find_event(const evlog_rec_t *ev,int n,int type,int arg,uint64_t from,uint64_t to){
+    for(int i=0;i<n;i++)
+        if(ev[i].type==type && (arg<0 || ev[i].arg==arg) && ev[i].ts>=from && ev[i].ts<to) return ev[i].ts;
+    return 0;
+}
+
+static void dump_metrics(void){
+    struct sockaddr_un a={ .sun_family=AF_UNIX };
+    snprintf(a.sun_path,sizeof(a.sun_path),"%s/stats.sock",workdir);
+    int fd=socket(AF_UNIX,SOCK_STREAM|SOCK_CLOEXEC,0);
+    if(fd<0 || connect(fd,(struct sockaddr*)&a,sizeof(a))<0){ perror("stats socket"); if(fd>=0) close(fd); return; }
+    char buf[4096];
+    ssize_t n;
+    printf("\nmonitor_control metrics:\n");
+    while((n=read(fd,buf,sizeof(buf)))>0) fwrite(buf,1,n,stdout);
+    close(fd);
+}
+
+// ---- process ของ monitor_control ----
+
+static int write_env(void){
+    char path[128];
+    snprintf(path,sizeof(path),"%s/.env",workdir);
+    FILE *fp=fopen(path,"w");
+    if(!fp){ perror(path); return -1; }
+    fprintf(fp,"MONITOR_PORT=%d\n",port);
+    for(int m=0;m<NMON;m++){
+        fprintf(fp,"MONITOR_IP%d=127.0.0.%d\n",m+1,m+1);
+        if(use_bin) fprintf(fp,"MONITOR_PROTO%d=bin\n",m+1);
+    }
+    fprintf(fp,"STATUS_PORT=%d\nDISCOVERY_PORT=0\n",port+1);
+    fprintf(fp,"METRICS_SOCKET=%s/stats.sock\n",workdir);
+    fprintf(fp,"DISPLAY_SOCKET=%s/oled.sock\n",workdir);
+    fprintf(fp,"EVENT_LOG=%s/events.bin\nEVENT_LOG_FORMAT=bin\n",workdir);
+    fprintf(fp,"SHUTDOWN_CMD=true\n");
+    if(sim_chip) fprintf(fp,"GPIO_CHIP=%s\n",sim_chip);
+    fclose(fp);
+
+    snprintf(path,sizeof(path),"%s/fonts",workdir);
+    mkdir(path,0755);
+    char target[4096];
+    if(!realpath(font,target)){ perror(font); return -1; }
+    snprintf(path,sizeof(path),"%s/fonts/NotoSerifThai.ttf",workdir);
+    if(symlink(target,path)<0){ perror("symlink font"); return -1; }
+    return 0;
+}
+
+static int spawn(void){
+    char bin[4096];
+    if(!realpath(binary,bin)){ perror(binary); return -1; }
+    char log[128], env[128];
+    snprintf(log,sizeof(log),"%s/monitor_control.log",workdir);
+    child=fork();
+    if(child<0){ perror("fork"); return -1; }
+    if(child==0){
+        int fd=open(log,O_WRONLY|O_CREAT|O_TRUNC,0644);
+        if(fd>=0){ dup2(fd,1); dup2(fd,2); close(fd); }
+        if(chdir(workdir)<0) _exit(127);
+        setenv("GPIO_MOCK_INIT","6=1,7=1,8=1,9=1",1);
+        setenv("GPIO_MOCK_CTL",ctl_addr.sun_path,1);
+        snprintf(env,sizeof(env),"%s/oled.sock",workdir);
+        setenv("I2C_MEM_CAPTURE",env,1);
+        if(bus_hz){ snprintf(env,sizeof(env),"%u",bus_hz); setenv("I2C_MEM_CLOCK",env,1); }
+        execl(bin,bin,(char*)NULL);
+        _exit(127);
+    }
+    return 0;
+}
+
+static int child_exited(int ms){
+    for(int i=0;i<=ms/10;i++){
+        int st;
+        if(waitpid(child,&st,WNOHANG)==child){ child=-1; return 1; }
+        usleep(10000);
+    }
+    return 0;
+}
+
+// monitor_control พิมพ์ "boot: ..." เมื่อฟอนต์โหลดเสร็จและวาดหน้าจอแล้ว
+static int booted(void){
+    char path[128], line[512];
+    snprintf(path,sizeof(path),"%s/monitor_control.log",workdir);
+    FILE *fp=fopen(path,"r");
+    int found=0;
+    while(fp && !found && fgets(line,sizeof(line),fp)) found=strncmp(line,"boot: ",6)==0 && strstr(line,"ready");
+    if(fp) fclose(fp);
+    return found;
+}
+
+// รอจน monitor_control พร้อม: หน้าจอวาดแล้ว (ฟอนต์โหลดเสร็จ) และ ping รอบแรกไปถึง monitor ทุกตัว
+static int wait_ready(void){
+    uint64_t deadline=now_ns()+10000000000ull;
+    while(now_ns()<deadline){
+        if(child_exited(0)){ fprintf(stderr,"monitor_control exited during startup (see %s/monitor_control.log)\n",workdir); return -1; }
+        pthread_mutex_lock(&lock);
+        int ok=frames>0;
+        for(int m=0;m<NMON;m++) ok&=pongs[m]>0 || pings[m]>0;
+        pthread_mutex_unlock(&lock);
+        struct stat st;
+        if(ok && (sim_dir || stat(ctl_addr.sun_path,&st)==0) && booted()){
+            usleep(200000 + ping_delay_ms*1000);   // ให้ผล pong ถึง main loop ก่อนเริ่ม
+            return 0;
+        }
+        usleep(10000);
+    }
+    fprintf(stderr,"monitor_control not ready after 10 s (see %s/monitor_control.log)\n",workdir);
+    return -1;
+}
+
+static void cleanup(void){
+    static const char *files[] = { ".env", "fonts/NotoSerifThai.ttf", "oled.sock", "gpio.sock", "stats.sock",
+                                   "events.bin", "monitor_control.log", "oled_last.bin" };
+    char path[128];
+    if(keep){ printf("\nworkdir kept: %s\n",workdir); return; }
+    for(size_t i=0;i<sizeof(files)/sizeof(files[0]);i++){
+        snprintf(path,sizeof(path),"%s/%s",workdir,files[i]);
+        unlink(path);
+    }
+    snprintf(path,sizeof(path),"%s/fonts",workdir);
+    rmdir(path);
+    rmdir(workdir);
+}
+
+static void usage(const char *argv0){
+    fprintf(stderr,"usage: %s -f font.ttf [-b monitor_control] [-p ascii|bin] [-d ping_delay_ms] [-l ping_loss_%%]\n"
+                   "          [-L cmd_loss_%%] [-c bus_hz] [-n rounds] [-g gap_ms] [-s script] [-P port]\n"
+                   "          [-G gpio-sim dir -C chip] [-k]\n",argv0);
+    exit(2);
+}
+
+int main(int argc,char **argv){
+    int opt;
+    font=getenv("BENCH_FONT");
+    while((opt=getopt(argc,argv,"b:f:p:d:l:L:c:n:g:s:P:G:C:k"))!=-1){
+        switch(opt){
+        case 'b': binary=optarg; break;
+        case 'f': font=optarg; break;
+        case 'p': use_bin=strcmp(optarg,"bin")==0; break;
+        case 'd': ping_delay_ms=atoi(optarg); break;
+        case 'l': ping_loss=atoi(optarg); break;
+        case 'L': cmd_loss=atoi(optarg); break;
+        case 'c': bus_hz=strtoul(optarg,NULL,10); break;
+        case 'n': rounds=atoi(optarg); break;
+        case 'g': gap_ms=atoi(optarg); break;
+        case 's': script=optarg; break;
+        case 'P': port=atoi(optarg); break;
+        case 'G': sim_dir=optarg; break;
+        case 'C': sim_chip=optarg; break;
+        case 'k': keep=1; break;
+        default: usage(argv[0]);
+        }
+    }
+    if(!font) usage(argv[0]);
+    srand(1);
+    setvbuf(stdout,NULL,_IOLBF,0);
+    signal(SIGPIPE,SIG_IGN);
+
+    if(load_script()<0) return 2;
+    plan();
+
+    strcpy(workdir,"/tmp/e2e.XXXXXX");
+    if(!mkdtemp(workdir)){ perror("mkdtemp"); return 1; }
+    if(open_sockets()<0 || write_env()<0){ cleanup(); return 1; }
+    pthread_t th;
+    if(pthread_create(&th,NULL,stub_main,NULL)!=0){ perror("pthread_create"); return 1; }
+    if(sim_dir) inject((1<<NKEYS)-1,0);    // ปุ่มทั้งหมดอยู่ในสถานะปล่อยก่อนเริ่ม
+    if(spawn()<0 || wait_ready()<0){
+        if(child>0){ kill(child,SIGKILL); waitpid(child,NULL,0); }
+        atomic_store(&running,0);
+        pthread_join(th,NULL);
+        cleanup();
+        return 1;
+    }
+
+    printf("e2e: %d monitors (%s), ping delay %d ms loss %d%%, cmd loss %d%%, bus %s, %d steps\n",
+           NMON,use_bin?"bin":"ascii",ping_delay_ms,ping_loss,cmd_loss,bus_hz?"simulated":"unthrottled",nsteps);
+
+    int fetched=0;
+    for(int i=0;i<nsteps;i++){
+        step_t *s=&steps[i];
+        if(s->shutdown && !fetched){ dump_metrics(); fetched=1; }
+        uint64_t t=now_ns();
+        if(s->keys){
+            s->inject=inject(s->keys,1);
+            sleep_until(s->inject+(uint64_t)s->hold_ms*1000000);
+            // หลังปิดเครื่อง process ออกไปแล้ว ไม่มีใครรับการปล่อยปุ่ม
+            t=now_ns();
+            if(!s->shutdown || !child_exited(0)) s->release=t=inject(s->keys,0);
+        } else s->inject=t;
+        sleep_until(t+(uint64_t)s->gap_ms*1000000);
+        if(keep){
+            char name[32];
+            snprintf(name,sizeof(name),"step-%03d.pbm",i+1);
+            write_pbm(name);
+        }
+        if(s->shutdown) break;
+    }
+    if(!fetched && child>0) dump_metrics();
+
+    // ขั้นปิดเครื่อง: monitor_control ออกเอง ไม่งั้นส่ง SIGINT (main เขียน log ที่ค้างแล้วออก)
+    if(child>0 && !child_exited(2000)){
+        kill(child,SIGINT);
+        if(!child_exited(2000)){ kill(child,SIGKILL); waitpid(child,NULL,0); }
+    }
+    usleep(100000);
+    atomic_store(&running,0);
+    pthread_join(th,NULL);
+
+    int nev, dups, missing=0, extra=0, expected=0, failed=0;
+    evlog_rec_t *ev=read_events(&nev);
+    check(&dups);
+
+    uint64_t *pkt=calloc(nsteps*NKEYS+1,sizeof(uint64_t)), *sel_pkt=calloc(nsteps*NKEYS+1,sizeof(uint64_t));
+    uint64_t *oled=calloc(nsteps+1,sizeof(uint64_t)), *sel_oled=calloc(nsteps+1,sizeof(uint64_t));
+    uint64_t *edge=calloc(nsteps*NKEYS+1,sizeof(uint64_t));
+    int npkt=0, nsel=0, noled=0, nsel_oled=0, nedge=0;
+    for(int i=0;i<nsteps;i++){
+        step_t *s=&steps[i];
+        if(!s->keys || !s->inject) continue;
+        uint64_t end=i+1<nsteps && steps[i+1].inject ? steps[i+1].inject : UINT64_MAX;
+        for(int k=0;k<NKEYS;k++){
+            if(!(s->keys>>k&1)) continue;
+            uint64_t t=find_event(ev,nev,EV_PRESS,k,s->inject,end);
+            if(t) edge[nedge++]=t-s->inject;
+        }
+        int sel=(s->keys&MON_KEYS)!=0;
+        if(!s->combo && !s->shutdown){
+            uint64_t t=first_change(s->inject,end);
+            if(t){ if(sel) sel_oled[nsel_oled++]=t-s->inject; else oled[noled++]=t-s->inject; }
+        }
+        if(!s->checked) continue;
+        for(int e=0;e<s->nexp;e++){
+            expect_t *x=&s->exp[e];
+            expected++;
+            if(!x->matched){
+                missing++;
+                printf("step %d: %s -> monitor%d missing cmd %d (count %d)\n",i+1,keys[__builtin_ctz(s->keys)].name,
+                       x->monitor+1,x->cmd,x->count);
+                continue;
+            }
+            if(x->cmd==PROTO_SELECT) sel_pkt[nsel++]=x->ts-s->inject;
+            else pkt[npkt++]=x->ts-s->inject;
+        }
+        if(s->extra){
+            extra+=s->extra;
+            printf("step %d: %d unexpected command(s)\n",i+1,s->extra);
+        }
+    }
+    putchar('\n');
+    report("press -> packet",pkt,npkt);
+    report("select -> packet",sel_pkt,nsel);
+    report("press -> oled",oled,noled);
+    report("select -> oled",sel_oled,nsel_oled);
+    report("edge -> handler",edge,nedge);
+
+    for(int i=0;i<nsteps;i++){
+        step_t *s=&steps[i];
+        if((!s->combo && !s->shutdown) || !s->inject) continue;
+        uint64_t end=i+1<nsteps && steps[i+1].inject ? steps[i+1].inject : UINT64_MAX;
+        uint64_t t=find_event(ev,nev,s->combo ? EV_COMBO : EV_SHUTDOWN,-1,s->inject,end);
+        if(!t){
+            printf("%-18s step %d: no event\n",s->combo?"ip combo":"shutdown",i+1);
+            failed=1;
+            continue;
+        }
+        uint64_t o=first_change(t,end);
+        printf("%-18s hold -> event %.1f ms, event -> oled %s%.3f ms\n",s->combo?"ip combo":"shutdown",
+               (t-s->inject)/1e6,o?"":"(no change) ",o?(o-t)/1e6:0.0);
+    }
+
+    printf("commands           expected %d, received %d, missing %d, unexpected %d, duplicate seq %d, dropped by stub %u\n",
+           expected,nrx-dups,missing,extra,dups,cmds_dropped);
+    unsigned np=0,npo=0;
+    for(int m=0;m<NMON;m++){ np+=pings[m]; npo+=pongs[m]; }
+    printf("pings              %u received, %u answered, %u dropped\n",np,npo,pings_dropped);
+    // ทุก monitor ที่ตอบ pong ต้องถูกนับว่า up อย่างน้อยครั้งหนึ่ง (คำตอบต้อง match ได้ทุก index)
+    int never_up=0;
+    for(int m=0;m<NMON;m++){
+        int up=0;
+        for(int i=0;i<nev && !up;i++) up=ev[i].type==EV_HEALTH && ev[i].monitor==m && ev[i].result==1;
+        if(!up && pongs[m]){ printf("monitor%d: answered %u pings but never up\n",m+1,pongs[m]); never_up++; }
+    }
+    printf("oled               %u frames, %u lost by capture, %d changes\n",frames,frames_lost,nchanges);
+
+    cleanup();
+    return missing || extra || failed || never_up;
+}
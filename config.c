@@ -0,0 +1,294 @@
+#define _GNU_SOURCE
+#include "config.h"
+#include "proto.h"
+#include "evlog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <arpa/inet.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+
+// MONITOR_IP<N> ก่อนแปลง (MONITOR_PORT อาจอยู่บรรทัดหลัง)
+struct env_monitor {
+    char ip[INET_ADDRSTRLEN];
+    int proto;
+    int line;
+};
+
+static void fail(config_t *c,const char *path,int line,const char *fmt,...) __attribute__((format(printf,4,5)));
+static void fail(config_t *c,const char *path,int line,const char *fmt,...){
+    char msg[CONFIG_STR_MAX];
+    va_list ap;
+    va_start(ap,fmt);
+    vsnprintf(msg,sizeof(msg),fmt,ap);
+    va_end(ap);
+    fprintf(stderr,"config: %s:%d: %s\n",path,line,msg);
+    if(c->error[0]) return;
+    c->error_line=line;
+    snprintf(c->error,sizeof(c->error),"%s",msg);
+}
+
+// ล้างทั้ง buffer ก่อน: config สองก้อนที่ค่าเท่ากันต้องเท่ากันทุก byte (เทียบด้วย memcmp)
+static int set_str(char *dst,const char *v){
+    memset(dst,0,CONFIG_STR_MAX);
+    if(strlen(v)>=CONFIG_STR_MAX) return -1;
+    strcpy(dst,v);
+    return 0;
+}
+
+static int parse_port(const char *v,int min,int *out){
+    char *end;
+    long p=strtol(v,&end,10);
+    if(end==v || *end || p<min || p>65535) return -1;
+    *out=(int)p;
+    return 0;
+}
+
+static void defaults(config_t *c){
+    c->monitor_port=5000;
+    c->status_port=5001;
+    c->discovery_port=5002;
+    c->probe_seq=0;                    // monitor ที่ใช้อยู่ตอบได้แค่ "ping" -> "pong"
+    c->event_log_format=EVLOG_TEXT;
+    set_str(c->metrics_socket,"/run/monitor_control.sock");
+    set_str(c->display_socket,"/run/monitor_control.oled");
+    set_str(c->gpio_chip,"gpiochip0");
+    set_str(c->net_iface,"eth0");
+    set_str(c->shutdown_cmd,"shutdown -h now");
+    set_str(c->boot_screen,"oled_last.bin");
+}
+
+// บรรทัด KEY=value (value ว่าง = ไม่ตั้ง ใช้ค่าเริ่มต้น) บรรทัดว่าง/ขึ้นต้นด้วย # ข้าม
+static void parse_line(config_t *c,struct env_monitor *env,const char *path,int ln,char *line){
+    char *key=line;
+    while(*key==' ' || *key=='\t') key++;
+    size_t len=strlen(key);
+    while(len>0 && (key[len-1]=='\n' || key[len-1]=='\r' || key[len-1]==' ' || key[len-1]=='\t')) key[--len]=0;
+    if(!*key || *key=='#') return;
+
+    char *value=strchr(key,'=');
+    if(!value){ fail(c,path,ln,"missing '='"); return; }
+    *value++=0;
+    for(char *e=value-1;e>key && (e[-1]==' ' || e[-1]=='\t');) *--e=0;
+    while(*value==' ') value++;
+    if(!*value) return;
+
+    long n;
+    char *end;
+    if(strncmp(key,"MONITOR_IP",10)==0 || strncmp(key,"MONITOR_PROTO",13)==0){
+        // MONITOR_IP1, MONITOR_IP2, ... กี่ตัวก็ได้ (ไม่เกิน MONITOR_MAX)
+        const char *num=key+(key[8]=='I' ? 10 : 13);
+        n=strtol(num,&end,10);
+        if(end==num || *end || n<1 || n>MONITOR_MAX){ fail(c,path,ln,"%s: monitor number must be 1-%d",key,MONITOR_MAX); return; }
+        struct env_monitor *m=&env[n-1];
+        if(key[8]=='I'){
+            struct in_addr a;
+            if(inet_pton(AF_INET,value,&a)<=0){ fail(c,path,ln,"%s: bad address %s",key,value); return; }
+            snprintf(m->ip,sizeof(m->ip),"%s",value);
+            m->line=ln;
+        }
+        // MONITOR_PROTO1=bin -> monitor1 ใช้คำสั่งแบบ binary (มี seq/ack)
+        else if(strcmp(value,"bin")==0) m->proto=PROTO_BINARY;
+        else if(strcmp(value,"ascii")==0) m->proto=PROTO_ASCII;
+        else fail(c,path,ln,"%s: expected bin or ascii",key);
+    }
+    else if(strcmp(key,"MONITOR_PORT")==0){ if(parse_port(value,1,&c->monitor_port)<0) fail(c,path,ln,"bad %s %s",key,value); }
+    else if(strcmp(key,"STATUS_PORT")==0){ if(parse_port(value,1,&c->status_port)<0) fail(c,path,ln,"bad %s %s",key,value); }
+    else if(strcmp(key,"DISCOVERY_PORT")==0){ if(parse_port(value,0,&c->discovery_port)<0) fail(c,path,ln,"bad %s %s",key,value); }
+    else if(strcmp(key,"PROBE_SEQ")==0) c->probe_seq=atoi(value);
+    else if(strcmp(key,"EVENT_LOG_FORMAT")==0) c->event_log_format=strcmp(value,"bin")==0 ? EVLOG_BINARY : EVLOG_TEXT;
+    else if(strncmp(key,"GROUP_",6)==0 && key[6]){
+        // GROUP_lab=1,2,5
+        if(c->ngroups>=CONFIG_GROUP_MAX){ fail(c,path,ln,"too many groups (max %d)",CONFIG_GROUP_MAX); return; }
+        if(monitors_parse_group(&c->groups[c->ngroups],key+6,value)!=0){ fail(c,path,ln,"%s: bad monitor list %s",key,value); return; }
+        c->ngroups++;
+    }
+    else {
+        static const struct { const char *key; size_t off; } strs[]={
+            { "DISCOVERY_GROUP", offsetof(config_t,discovery_group) },
+            { "METRICS_SOCKET",  offsetof(config_t,metrics_socket) },
+            { "DISPLAY_SOCKET",  offsetof(config_t,display_socket) },
+            { "EVENT_LOG",       offsetof(config_t,event_log) },
+            { "GPIO_CHIP",       offsetof(config_t,gpio_chip) },
+            { "NET_IFACE",       offsetof(config_t,net_iface) },
+            { "SHUTDOWN_CMD",    offsetof(config_t,shutdown_cmd) },
+            { "BOOT_SCREEN",     offsetof(config_t,boot_screen) },
+        };
+        for(size_t i=0;i<sizeof(strs)/sizeof(strs[0]);i++){
+            if(strcmp(key,strs[i].key)!=0) continue;
+            if(set_str((char*)c+strs[i].off,value)<0) fail(c,path,ln,"%s: value too long",key);
+            return;
+        }
+        // key ที่ไม่รู้จักข้ามเงียบๆ (.env ใช้ร่วมกับโปรแกรมอื่นได้)
+    }
+}
+
+config_t *config_load(const char *path){
+    config_t *c=calloc(1,sizeof(*c));
+    struct env_monitor *env=calloc(MONITOR_MAX,sizeof(*env));
+    if(!c || !env){ perror("config"); free(c); free(env); return NULL; }
+    defaults(c);
+
+    FILE *fp=fopen(path,"r");
+    if(!fp){
+        fprintf(stderr,"config: %s: %s\n",path,strerror(errno));
+        snprintf(c->error,sizeof(c->error),"%s",strerror(errno));
+    } else {
+        char *line=NULL;
+        size_t cap=0;
+        for(int ln=1;getline(&line,&cap,fp)>=0;ln++) parse_line(c,env,path,ln,line);
+        free(line);
+        fclose(fp);
+    }
+    if(strcmp(c->boot_screen,"none")==0) set_str(c->boot_screen,"");
+    if(strcmp(c->display_socket,"none")==0) set_str(c->display_socket,"");
+
+    int any=0;
+    for(int i=0;i<MONITOR_MAX;i++) any|=env[i].ip[0]!=0;
+    if(!any){
+        static const char *fallback[]={ "192.168.1.111", "192.168.1.111", "192.168.1.130" };
+        for(int i=0;i<3;i++) snprintf(env[i].ip,sizeof(env[i].ip),"%s",fallback[i]);
+    }
+
+    // แปลง address ครั้งเดียวตรงนี้ (ไม่ต้องแปลงตอนเปลี่ยนจอ) เลขที่เว้นไว้ไม่กินช่อง
+    for(int i=0;i<MONITOR_MAX;i++){
+        struct env_monitor *m=&env[i];
+        if(!m->ip[0]) continue;
+        if(monitors_make(&c->monitors[c->nmonitors],m->ip,c->monitor_port,m->proto,NULL)==0) c->nmonitors++;
+        else fail(c,path,m->line,"MONITOR_IP%d: bad address %s",i+1,m->ip);
+    }
+    free(env);
+    return c;
+}
+
+int config_restart_keys(const config_t *a,const config_t *b,char *buf,size_t len){
+    int n=0;
+    size_t off=0;
+    buf[0]=0;
+#define RESTART_KEY(name,same) \
+    if(!(same)){ off+=snprintf(buf+off,off<len?len-off:0,"%s%s",n?" ":"",name); n++; }
+    RESTART_KEY("STATUS_PORT",a->status_port==b->status_port)
+    RESTART_KEY("DISCOVERY_PORT",a->discovery_port==b->discovery_port)
+    RESTART_KEY("DISCOVERY_GROUP",strcmp(a->discovery_group,b->discovery_group)==0)
+    RESTART_KEY("PROBE_SEQ",a->probe_seq==b->probe_seq)
+    RESTART_KEY("METRICS_SOCKET",strcmp(a->metrics_socket,b->metrics_socket)==0)
+    RESTART_KEY("DISPLAY_SOCKET",strcmp(a->display_socket,b->display_socket)==0)
+    RESTART_KEY("EVENT_LOG",strcmp(a->event_log,b->event_log)==0)
+    RESTART_KEY("EVENT_LOG_FORMAT",a->event_log_format==b->event_log_format)
+    RESTART_KEY("GPIO_CHIP",strcmp(a->gpio_chip,b->gpio_chip)==0)
+#undef RESTART_KEY
+    return n;
+}
+
+static char *watch_path;
+static const char *watch_name;      // ชื่อไฟล์ใน directory ที่เฝ้า
+static int inotify_fd = -1;
+static int event_fd = -1;           // แจ้ง main loop ว่ามี config ใหม่
+static int wake_fd = -1;            // ปลุก thread ให้เลิก
+static atomic_int running;
+static pthread_t watch_thread;
+static config_t *last;              // ของ thread: ก้อนล่าสุดที่อ่าน (ไม่ส่งซ้ำถ้าไฟล์ไม่เปลี่ยนจริง)
+static _Atomic(config_t *) ready;   // ก้อนใหม่ที่รอ main loop รับ
+
+static void reload(void){
+    config_t *c=config_load(watch_path);
+    if(!c) return;
+    if(memcmp(c,last,sizeof(*c))==0){ free(c); return; }   // touch / เขียนค่าเดิมซ้ำ
+    config_t *copy=malloc(sizeof(*copy));
+    if(!copy){ perror("config"); free(c); return; }
+    memcpy(copy,c,sizeof(*copy));
+    free(last);
+    last=c;
+
+    free(atomic_exchange(&ready,copy));
+    uint64_t one=1;
+    if(write(event_fd,&one,sizeof(one))<0 && errno!=EAGAIN) perror("config notify");
+}
+
+static void *watch_main(void *arg){
+    (void)arg;
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int dirty=0;
+    while(atomic_load(&running)){
+        struct pollfd p[2]={ { inotify_fd, POLLIN, 0 }, { wake_fd, POLLIN, 0 } };
+        int r=poll(p,2,dirty ? CONFIG_SETTLE_MS : -1);
+        if(r<0){
+            if(errno==EINTR) continue;
+            perror("config poll");
+            break;
+        }
+        if(p[1].revents) break;
+        if(r==0){ dirty=0; reload(); continue; }
+
+        ssize_t n;
+        while((n=read(inotify_fd,buf,sizeof(buf)))>0){
+            for(char *q=buf;q<buf+n;){
+                const struct inotify_event *e=(const struct inotify_event*)q;
+                if(e->len && strcmp(e->name,watch_name)==0) dirty=1;
+                q+=sizeof(*e)+e->len;
+            }
+        }
+    }
+    return NULL;
+}
+
+int config_watch_start(const char *path,const config_t *current){
+    watch_path=strdup(path);
+    last=malloc(sizeof(*last));
+    if(!watch_path || !last){ perror("config"); return -1; }
+    memcpy(last,current,sizeof(*last));
+
+    // เฝ้าที่ directory: editor ส่วนใหญ่เขียนไฟล์ใหม่แล้ว rename ทับ (watch ของไฟล์เดิมจะหายไปด้วย)
+    char *slash=strrchr(watch_path,'/');
+    char dir[256];
+    if(slash){
+        watch_name=slash+1;
+        snprintf(dir,sizeof(dir),"%.*s",(int)(slash-watch_path) ? (int)(slash-watch_path) : 1,watch_path);
+    } else {
+        watch_name=watch_path;
+        snprintf(dir,sizeof(dir),".");
+    }
+
+    inotify_fd=inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+    if(inotify_fd<0){ perror("config inotify"); return -1; }
+    if(inotify_add_watch(inotify_fd,dir,IN_CLOSE_WRITE|IN_MOVED_TO)<0){ perror("config watch"); return -1; }
+    event_fd=eventfd(0,EFD_NONBLOCK|EFD_CLOEXEC);
+    wake_fd=eventfd(0,EFD_NONBLOCK|EFD_CLOEXEC);
+    if(event_fd<0 || wake_fd<0){ perror("config eventfd"); return -1; }
+
+    atomic_store(&running,1);
+    if(pthread_create(&watch_thread,NULL,watch_main,NULL)!=0){
+        perror("config thread");
+        atomic_store(&running,0);
+        return -1;
+    }
+    return 0;
+}
+
+int config_event_fd(void){ return event_fd; }
+
+config_t *config_take(void){
+    uint64_t n;
+    if(read(event_fd,&n,sizeof(n))<0 && errno!=EAGAIN) perror("config event");
+    return atomic_exchange(&ready,NULL);
+}
+
+void config_watch_stop(void){
+    if(!atomic_exchange(&running,0)) return;
+    uint64_t one=1;
+    if(write(wake_fd,&one,sizeof(one))<0) perror("config wake");
+    pthread_join(watch_thread,NULL);
+    close(inotify_fd);
+    inotify_fd=-1;
+    free(atomic_exchange(&ready,NULL));
+    free(last);
+    last=NULL;
+}
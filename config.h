@@ -0,0 +1,51 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stddef.h>
+#include "monitors.h"
+
+#ifndef CONFIG_SETTLE_MS
+#define CONFIG_SETTLE_MS 200    // .env เปลี่ยนแล้วเงียบนานเท่านี้ค่อยอ่าน (editor เขียนหลายครั้ง/rename ทับ)
+#endif
+#define CONFIG_GROUP_MAX 16
+#define CONFIG_STR_MAX 128
+
+// ค่าทั้งหมดจาก .env อ่านใหม่ทั้งก้อนทุกครั้ง (ไม่แก้ก้อนที่ใช้อยู่) address แปลงไว้แล้ว
+typedef struct {
+    monitor_t monitors[MONITOR_MAX];    // MONITOR_IP<N> เรียงตาม N (เว้นเลขได้) + MONITOR_PORT/MONITOR_PROTO<N>
+    int nmonitors;
+    monitor_group_t groups[CONFIG_GROUP_MAX];   // GROUP_<name>=1,2,5
+    int ngroups;
+    int monitor_port;
+    int status_port;                    // monitor ส่ง heartbeat/สถานะมาที่ port นี้
+    int discovery_port;                 // 0 = ไม่ค้นหา monitor
+    int probe_seq;                      // 1 = "ping <seq>" (monitor รุ่นใหม่), 0 = "ping" เฉยๆ
+    int event_log_format;               // EVLOG_TEXT / EVLOG_BINARY
+    char discovery_group[CONFIG_STR_MAX];   // "" = broadcast อย่างเดียว
+    char metrics_socket[CONFIG_STR_MAX];    // Unix socket อ่านสถิติ
+    char display_socket[CONFIG_STR_MAX];    // process อื่นวาดลง OLED (oled_srv.h) "" = ไม่เปิด (DISPLAY_SOCKET=none)
+    char event_log[CONFIG_STR_MAX];         // "" = stdout
+    char gpio_chip[CONFIG_STR_MAX];         // เช่น chip ของ gpio-sim ตอนทดสอบ
+    char net_iface[CONFIG_STR_MAX];         // หน้าจอ IP แสดง address ของ interface นี้
+    char shutdown_cmd[CONFIG_STR_MAX];      // ทดสอบตั้งเป็น true
+    char boot_screen[CONFIG_STR_MAX];       // ภาพล่าสุดบน OLED ตอนเปิดเครื่อง "" = ไม่ใช้ (BOOT_SCREEN=none)
+    int error_line;                     // บรรทัดแรกที่ผิด (0 = เปิดไฟล์ไม่ได้ ถ้า error ไม่ว่าง)
+    char error[CONFIG_STR_MAX];         // "" = ใช้ได้ทั้งไฟล์
+} config_t;
+
+// อ่าน path ค่าที่ไม่มีในไฟล์ใช้ค่าเริ่มต้น บรรทัดที่ผิดถูกข้าม (พิมพ์ลง stderr ทุกบรรทัด จำบรรทัดแรกไว้ใน error)
+// คืน NULL ถ้า memory ไม่พอ ผู้เรียก free() เอง
+config_t *config_load(const char *path);
+
+// key ที่ต่างกันระหว่าง a กับ b แต่มีผลเฉพาะตอนเริ่มโปรแกรม (socket, GPIO, log) คั่นด้วย ' ' ลง buf คืนจำนวน
+int config_restart_keys(const config_t *a,const config_t *b,char *buf,size_t len);
+
+// thread แยกเฝ้า path ด้วย inotify (ที่ directory เพื่อให้เห็นการ rename ทับ) อ่าน/ตรวจ/แปลง address เสร็จในนั้น
+// แล้วแจ้ง main loop ทาง config_event_fd() ไฟล์ที่อ่านแล้วเหมือน current (หรือครั้งก่อน) จะไม่ถูกส่ง
+int config_watch_start(const char *path,const config_t *current);
+int config_event_fd(void);
+// config ใหม่ล่าสุด (ตัวที่มาก่อนแล้วยังไม่ได้รับถูกทิ้ง) หรือ NULL ผู้เรียก free() เอง
+config_t *config_take(void);
+void config_watch_stop(void);
+
+#endif
@@ -0,0 +1,118 @@
+#include "discovery.h"
+#include "proto.h"
+#include "evloop.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+static int sock = -1;
+static int disc_port;
+static struct in_addr mcast_group;
+static int use_mcast;
+static evtimer_t *timer;
+static void (*found_cb)(const struct sockaddr_in *addr,int proto,const char *name);
+
+static void send_to(in_addr_t dst){
+    struct sockaddr_in a;
+    memset(&a,0,sizeof(a));
+    a.sin_family=AF_INET;
+    a.sin_port=htons(disc_port);
+    a.sin_addr.s_addr=dst;
+    if(sendto(sock,"discover",8,0,(struct sockaddr*)&a,sizeof(a))<0 && errno!=ENETUNREACH)
+        perror("discovery send");
+}
+
+void discovery_query(void){
+    if(sock<0) return;
+    send_to(htonl(INADDR_BROADCAST));
+    if(use_mcast) send_to(mcast_group.s_addr);
+}
+
+static void on_timer(void *ctx){
+    (void)ctx;
+    discovery_query();
+}
+
+// "monitor <port> [ascii|bin] [name]"
+static void handle(const struct sockaddr_in *from,char *msg){
+    if(strncmp(msg,"monitor ",8)!=0) return;   // รวม "discover" ของตัวเองที่วนกลับมา
+    char *p=msg+8, *end;
+    long port=strtol(p,&end,10);
+    if(end==p || port<=0 || port>65535 || (*end && *end!=' ')) return;
+    p=*end ? end+1 : end;
+
+    int proto=PROTO_ASCII;
+    if(strncmp(p,"bin",3)==0 && (p[3]==0 || p[3]==' ')){ proto=PROTO_BINARY; p+=p[3] ? 4 : 3; }
+    else if(strncmp(p,"ascii",5)==0 && (p[5]==0 || p[5]==' ')) p+=p[5] ? 6 : 5;
+
+    struct sockaddr_in a;
+    memset(&a,0,sizeof(a));
+    a.sin_family=AF_INET;
+    a.sin_port=htons((uint16_t)port);
+    a.sin_addr=from->sin_addr;
+    if(found_cb) found_cb(&a,proto,*p ? p : NULL);
+}
+
+static void on_readable(int fd,uint32_t events,void *ctx){
+    (void)events; (void)ctx;
+    char buf[96];
+    struct sockaddr_in from;
+    socklen_t len=sizeof(from);
+    ssize_t n;
+    while((n=recvfrom(fd,buf,sizeof(buf)-1,MSG_DONTWAIT,(struct sockaddr*)&from,&len))>=0){
+        buf[n]=0;
+        while(n>0 && (buf[n-1]=='\n' || buf[n-1]=='\r')) buf[--n]=0;
+        handle(&from,buf);
+        len=sizeof(from);
+    }
+}
+
+int discovery_start(int port,const char *group,
+                    void (*on_found)(const struct sockaddr_in *addr,int proto,const char *name)){
+    disc_port=port;
+    found_cb=on_found;
+
+    sock=socket(AF_INET,SOCK_DGRAM|SOCK_NONBLOCK|SOCK_CLOEXEC,0);
+    if(sock<0){ perror("discovery socket"); return -1; }
+    int one=1;
+    setsockopt(sock,SOL_SOCKET,SO_REUSEADDR,&one,sizeof(one));
+    setsockopt(sock,SOL_SOCKET,SO_BROADCAST,&one,sizeof(one));
+
+    struct sockaddr_in a;
+    memset(&a,0,sizeof(a));
+    a.sin_family=AF_INET;
+    a.sin_port=htons(port);
+    a.sin_addr.s_addr=htonl(INADDR_ANY);
+    if(bind(sock,(struct sockaddr*)&a,sizeof(a))<0){ perror("discovery bind"); close(sock); sock=-1; return -1; }
+
+    if(group && *group){
+        struct ip_mreq mreq;
+        memset(&mreq,0,sizeof(mreq));
+        if(inet_pton(AF_INET,group,&mreq.imr_multiaddr)<=0){
+            fprintf(stderr,"discovery: invalid group %s\n",group);
+        } else if(setsockopt(sock,IPPROTO_IP,IP_ADD_MEMBERSHIP,&mreq,sizeof(mreq))<0){
+            perror("discovery join");      // network อาจยังไม่ขึ้น ใช้ broadcast ไปก่อน
+        } else {
+            mcast_group=mreq.imr_multiaddr;
+            use_mcast=1;
+        }
+    }
+
+    if(evloop_add(sock,EPOLLIN,on_readable,NULL)<0) return -1;
+    timer=evtimer_new(on_timer,NULL);
+    if(!timer) return -1;
+    evtimer_arm(timer,1,DISCOVERY_INTERVAL_MS);     // ถามรอบแรกทันทีหลังเข้า loop
+    return 0;
+}
+
+void discovery_stop(void){
+    if(sock<0) return;
+    evtimer_disarm(timer);
+    evloop_del(sock);
+    close(sock);
+    sock=-1;
+}
@@ -0,0 +1,25 @@
+#ifndef DISCOVERY_H
+#define DISCOVERY_H
+
+#include <netinet/in.h>
+
+#ifndef DISCOVERY_INTERVAL_MS
+#define DISCOVERY_INTERVAL_MS 30000 // ถามหา monitor ใหม่ซ้ำทุกๆ เท่านี้
+#endif
+
+// ค้นหา monitor ใน network วงเดียวกัน (ข้อความ ASCII บรรทัดเดียว ที่ DISCOVERY_PORT)
+//   controller -> broadcast/multicast   "discover"
+//   monitor    -> controller            "monitor <port> [ascii|bin] [name]"
+// monitor ที่เพิ่งเปิดส่ง "monitor ..." ไป broadcast/multicast ที่ port เดียวกันเองได้โดยไม่ต้องรอถาม
+// address ของ monitor คือ IP ผู้ส่ง + <port> ที่ระบุ
+//
+// group = multicast group (เช่น "239.255.50.50") หรือ NULL ถ้าใช้ broadcast อย่างเดียว
+// on_found ถูกเรียกทุกครั้งที่ได้คำตอบ (รวมตัวที่รู้จักแล้ว ผู้เรียกกรองซ้ำเอง)
+int discovery_start(int port,const char *group,
+                    void (*on_found)(const struct sockaddr_in *addr,int proto,const char *name));
+
+// ถามหา monitor ทันที (นอกรอบปกติ)
+void discovery_query(void);
+void discovery_stop(void);
+
+#endif
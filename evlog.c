@@ -0,0 +1,164 @@
+#include "evlog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/eventfd.h>
+
+_Static_assert((EVLOG_RING&(EVLOG_RING-1))==0,"EVLOG_RING must be a power of two");
+
+#define EVLOG_TEXT_NAME(name,text,arg) text,
+#define EVLOG_ARG_NAME(name,text,arg) arg,
+static const char *type_names[EV_TYPES] = { EVLOG_TYPES(EVLOG_TEXT_NAME) };
+static const char *arg_names[EV_TYPES] = { EVLOG_TYPES(EVLOG_ARG_NAME) };
+
+static evlog_rec_t ring[EVLOG_RING];
+static _Atomic uint32_t head;       // เขียนโดย main loop
+static _Atomic uint32_t tail;       // เขียนโดย thread log
+static uint32_t tail_cache;         // ค่า tail ล่าสุดที่ main loop เห็น (ลดการอ่านข้าม core)
+static _Atomic uint32_t dropped;
+
+static int out_fd = -1;
+static int out_format;
+static int wake_fd = -1;            // ring เกินครึ่ง/ให้เลิก
+static atomic_int running;
+static pthread_t log_thread;
+
+static uint64_t now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint64_t)ts.tv_sec*1000000000u+ts.tv_nsec;
+}
+
+static void kick(void){
+    uint64_t one=1;
+    if(write(wake_fd,&one,sizeof(one))<0 && errno!=EAGAIN) perror("evlog wake");
+}
+
+void evlog_write(evlog_type_t type,int monitor,int arg,int result){
+    if(!atomic_load_explicit(&running,memory_order_relaxed)) return;
+    uint32_t h=atomic_load_explicit(&head,memory_order_relaxed);
+    if(h-tail_cache>=EVLOG_RING){
+        tail_cache=atomic_load_explicit(&tail,memory_order_acquire);
+        if(h-tail_cache>=EVLOG_RING){
+            atomic_fetch_add_explicit(&dropped,1,memory_order_relaxed);
+            return;
+        }
+    }
+    evlog_rec_t *r=&ring[h&(EVLOG_RING-1)];
+    r->ts=now_ns();
+    r->type=(uint8_t)type;
+    r->arg=(uint8_t)arg;
+    r->monitor=(int16_t)monitor;
+    r->result=result;
+    atomic_store_explicit(&head,h+1,memory_order_release);
+    // ปลุกเฉพาะตอนข้ามครึ่ง ring ปกติ thread log ตื่นเองตามรอบ จึงไม่มี syscall ต่อ record
+    if(h+1-tail_cache==EVLOG_RING/2) kick();
+}
+
+uint32_t evlog_dropped(void){ return atomic_load_explicit(&dropped,memory_order_relaxed); }
+
+int evlog_format(char *buf,int len,const evlog_rec_t *r){
+    const char *t=r->type<EV_TYPES ? type_names[r->type] : "?";
+    const char *a=r->type<EV_TYPES ? arg_names[r->type] : "arg";
+    int n=snprintf(buf,len,"%llu.%06llu %-8s",
+                   (unsigned long long)(r->ts/1000000000u),(unsigned long long)(r->ts%1000000000u/1000),t);
+    if(n<len && r->monitor>=0) n+=snprintf(buf+n,len-n," monitor%d",r->monitor+1);
+    if(n<len && strcmp(a,"-")!=0) n+=snprintf(buf+n,len-n," %s=%u",a,r->arg);
+    if(n<len) n+=snprintf(buf+n,len-n," result=%d",(int)r->result);
+    return n;
+}
+
+static void write_all(const void *buf,size_t len){
+    const char *p=buf;
+    while(len>0){
+        ssize_t n=write(out_fd,p,len);
+        if(n<0){ if(errno==EINTR) continue; return; }
+        p+=n;
+        len-=n;
+    }
+}
+
+// อ่านทุก record ที่มีออกไปเขียน (ฝั่ง consumer เดียว)
+static void drain(void){
+    static uint32_t last_dropped;
+    uint32_t t=atomic_load_explicit(&tail,memory_order_relaxed);
+    uint32_t h=atomic_load_explicit(&head,memory_order_acquire);
+    char text[4096];
+    int tn=0;
+
+    while(t!=h){
+        const evlog_rec_t *r=&ring[t&(EVLOG_RING-1)];
+        if(out_format==EVLOG_BINARY){
+            // ช่วงที่ต่อกันใน ring เขียนทีเดียว
+            uint32_t n=h-t, room=EVLOG_RING-(t&(EVLOG_RING-1));
+            if(n>room) n=room;
+            write_all(r,n*sizeof(*r));
+            t+=n;
+        } else {
+            if(tn>(int)sizeof(text)-128){ write_all(text,tn); tn=0; }
+            tn+=evlog_format(text+tn,sizeof(text)-tn-1,r);
+            text[tn++]='\n';
+            t++;
+        }
+        atomic_store_explicit(&tail,t,memory_order_release);
+    }
+    uint32_t d=evlog_dropped();
+    if(out_format==EVLOG_TEXT && d!=last_dropped){
+        tn+=snprintf(text+tn,sizeof(text)-tn,"evlog: %u records dropped\n",d-last_dropped);
+        last_dropped=d;
+    }
+    if(tn) write_all(text,tn);
+}
+
+static void *log_main(void *arg){
+    (void)arg;
+    while(atomic_load(&running)){
+        struct pollfd p={ wake_fd, POLLIN, 0 };
+        if(poll(&p,1,EVLOG_FLUSH_MS)>0){
+            uint64_t n;
+            if(read(wake_fd,&n,sizeof(n))<0 && errno!=EAGAIN) perror("evlog wake");
+        }
+        drain();
+    }
+    drain();
+    return NULL;
+}
+
+int evlog_start(const char *path,int format){
+    if(!path || strcmp(path,"-")==0) out_fd=STDOUT_FILENO;
+    else {
+        out_fd=open(path,O_WRONLY|O_CREAT|O_APPEND|O_CLOEXEC,0644);
+        if(out_fd<0){ perror("evlog open"); return -1; }
+    }
+    out_format=format;
+    if(format==EVLOG_BINARY && lseek(out_fd,0,SEEK_END)==0){
+        uint8_t hdr[8]={ 'M','C','E','V', EVLOG_VERSION, sizeof(evlog_rec_t), 0, 0 };
+        write_all(hdr,sizeof(hdr));
+    }
+
+    wake_fd=eventfd(0,EFD_NONBLOCK|EFD_CLOEXEC);
+    if(wake_fd<0){ perror("evlog eventfd"); return -1; }
+    atomic_store(&running,1);
+    if(pthread_create(&log_thread,NULL,log_main,NULL)!=0){
+        perror("evlog thread");
+        atomic_store(&running,0);
+        return -1;
+    }
+    return 0;
+}
+
+void evlog_stop(void){
+    if(!atomic_exchange(&running,0)) return;
+    kick();
+    pthread_join(log_thread,NULL);
+    if(out_fd!=STDOUT_FILENO) close(out_fd);
+    close(wake_fd);
+    out_fd=wake_fd=-1;
+}
@@ -0,0 +1,68 @@
+#ifndef EVLOG_H
+#define EVLOG_H
+
+#include <stdint.h>
+
+// log เหตุการณ์แบบ binary: main loop เขียน record ขนาดคงที่ลง ring (single producer ไม่มี lock)
+// thread แยกอ่านออกไปเขียนลงไฟล์/stdout ring เต็มจะทิ้ง record แล้วนับไว้ ไม่ block ปุ่ม
+//
+// ไฟล์แบบ binary: header 8 byte ("MCEV", version, record size, 0, 0) แล้วตามด้วย record
+// record เขียนตรงจาก memory (little-endian บน NanoPi) อ่านกลับเป็นข้อความด้วย tools/evlogdump
+#define EVLOG_MAGIC "MCEV"
+#define EVLOG_VERSION 1
+
+#ifndef EVLOG_RING
+#define EVLOG_RING 1024             // จำนวน record (ต้องเป็นกำลังของ 2)
+#endif
+#ifndef EVLOG_FLUSH_MS
+#define EVLOG_FLUSH_MS 200          // thread เขียน log ตื่นมาอย่างช้าทุกๆ เท่านี้
+#endif
+
+// X(ชื่อ, ข้อความ, ความหมายของ arg)
+#define EVLOG_TYPES(X) \
+    X(EV_PRESS,    "press",    "key")   \
+    X(EV_RELEASE,  "release",  "key")   \
+    X(EV_SELECT,   "select",   "-")     \
+    X(EV_PAGE,     "page",     "key")   \
+    X(EV_GROUP,    "group",    "group") \
+    X(EV_SEND,     "send",     "cmd")   \
+    X(EV_LOST,     "lost",     "cmd")   \
+    X(EV_FOUND,    "found",    "proto") \
+    X(EV_HEALTH,   "health",   "-")     \
+    X(EV_STATUS,   "status",   "-")     \
+    X(EV_COMBO,    "ip",       "-")     \
+    X(EV_SHUTDOWN, "shutdown", "-")     \
+    X(EV_CONFIG,   "config",   "error") \
+    X(EV_NET,      "net",      "up")
+
+#define EVLOG_ENUM(name,text,arg) name,
+typedef enum { EVLOG_TYPES(EVLOG_ENUM) EV_TYPES } evlog_type_t;
+#undef EVLOG_ENUM
+
+// 16 byte: ts = ns ของ CLOCK_MONOTONIC, monitor = index (-1 = ไม่เกี่ยว/ทั้งกลุ่ม)
+typedef struct {
+    uint64_t ts;
+    uint8_t type;
+    uint8_t arg;
+    int16_t monitor;
+    int32_t result;
+} evlog_rec_t;
+
+_Static_assert(sizeof(evlog_rec_t)==16,"evlog_rec_t must be 16 bytes");
+
+enum { EVLOG_TEXT, EVLOG_BINARY };
+
+// path = NULL หรือ "-" เขียนลง stdout
+int evlog_start(const char *path,int format);
+void evlog_stop(void);
+
+// เรียกจาก main loop thread เท่านั้น
+void evlog_write(evlog_type_t type,int monitor,int arg,int result);
+
+// record ที่ถูกทิ้งเพราะ ring เต็ม
+uint32_t evlog_dropped(void);
+
+// แปลง record เป็นข้อความหนึ่งบรรทัด (ไม่มี '\n') ใช้ร่วมกับ tools/evlogdump
+int evlog_format(char *buf,int len,const evlog_rec_t *r);
+
+#endif
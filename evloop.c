@@ -0,0 +1,132 @@
+#include "evloop.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/timerfd.h>
+
+#define EVLOOP_MAX_EVENTS 16
+
+typedef struct handler {
+    int fd;
+    evloop_cb cb;
+    void *ctx;
+    struct handler *next;
+} handler_t;
+
+struct evtimer {
+    int fd;
+    int armed;
+    void (*cb)(void *ctx);
+    void *ctx;
+};
+
+static int epfd = -1;
+static int running;
+static handler_t *handlers;
+static handler_t *removed;          // ถูกลบระหว่าง dispatch รอ free หลังจบ batch
+static void (*prepare)(void);
+
+int evloop_init(void){
+    epfd=epoll_create1(EPOLL_CLOEXEC);
+    if(epfd<0){ perror("epoll_create1"); return -1; }
+    return 0;
+}
+
+int evloop_add(int fd,uint32_t events,evloop_cb cb,void *ctx){
+    handler_t *h=calloc(1,sizeof(*h));
+    if(!h) return -1;
+    h->fd=fd; h->cb=cb; h->ctx=ctx;
+
+    struct epoll_event ev={ .events=events, .data.ptr=h };
+    if(epoll_ctl(epfd,EPOLL_CTL_ADD,fd,&ev)<0){ perror("epoll_ctl"); free(h); return -1; }
+    h->next=handlers;
+    handlers=h;
+    return 0;
+}
+
+void evloop_del(int fd){
+    epoll_ctl(epfd,EPOLL_CTL_DEL,fd,NULL);
+    for(handler_t **pp=&handlers;*pp;pp=&(*pp)->next){
+        if((*pp)->fd==fd){
+            handler_t *h=*pp;
+            *pp=h->next;
+            h->cb=NULL;             // อาจยังอยู่ใน batch ของ epoll_wait รอบนี้
+            h->next=removed;
+            removed=h;
+            return;
+        }
+    }
+}
+
+void evloop_set_prepare(void (*fn)(void)){ prepare=fn; }
+
+int evloop_run(void){
+    struct epoll_event evs[EVLOOP_MAX_EVENTS];
+    running=1;
+    while(running){
+        if(prepare) prepare();
+        int n=epoll_wait(epfd,evs,EVLOOP_MAX_EVENTS,-1);
+        if(n<0){
+            if(errno==EINTR) continue;
+            perror("epoll_wait");
+            return -1;
+        }
+        for(int i=0;i<n && running;i++){
+            handler_t *h=evs[i].data.ptr;
+            if(h->cb) h->cb(h->fd,evs[i].events,h->ctx);
+        }
+        while(removed){
+            handler_t *h=removed;
+            removed=h->next;
+            free(h);
+        }
+    }
+    return 0;
+}
+
+void evloop_stop(void){ running=0; }
+
+static void timer_ready(int fd,uint32_t events,void *ctx){
+    (void)events;
+    evtimer_t *t=ctx;
+    uint64_t expirations;
+    if(read(fd,&expirations,sizeof(expirations))!=sizeof(expirations)) return;
+    struct itimerspec its;
+    if(timerfd_gettime(fd,&its)==0 && its.it_interval.tv_sec==0 && its.it_interval.tv_nsec==0)
+        t->armed=0;
+    t->cb(t->ctx);
+}
+
+evtimer_t *evtimer_new(void (*cb)(void *ctx),void *ctx){
+    evtimer_t *t=calloc(1,sizeof(*t));
+    if(!t) return NULL;
+    t->fd=timerfd_create(CLOCK_MONOTONIC,TFD_NONBLOCK|TFD_CLOEXEC);
+    if(t->fd<0){ perror("timerfd_create"); free(t); return NULL; }
+    t->cb=cb; t->ctx=ctx;
+    if(evloop_add(t->fd,EPOLLIN,timer_ready,t)<0){ close(t->fd); free(t); return NULL; }
+    return t;
+}
+
+void evtimer_arm(evtimer_t *t,int ms,int interval_ms){
+    struct itimerspec its;
+    memset(&its,0,sizeof(its));
+    if(ms<=0 && interval_ms<=0){ evtimer_disarm(t); return; }
+    if(ms<=0) ms=1;                 // it_value 0 คือปิด timer จึงใช้ 1 ms แทน "ทันที"
+    its.it_value.tv_sec=ms/1000;
+    its.it_value.tv_nsec=(long)(ms%1000)*1000000;
+    its.it_interval.tv_sec=interval_ms/1000;
+    its.it_interval.tv_nsec=(long)(interval_ms%1000)*1000000;
+    timerfd_settime(t->fd,0,&its,NULL);
+    t->armed=1;
+}
+
+void evtimer_disarm(evtimer_t *t){
+    struct itimerspec its;
+    memset(&its,0,sizeof(its));
+    timerfd_settime(t->fd,0,&its,NULL);
+    t->armed=0;
+}
+
+int evtimer_armed(const evtimer_t *t){ return t->armed; }
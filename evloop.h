@@ -0,0 +1,28 @@
+#ifndef EVLOOP_H
+#define EVLOOP_H
+
+#include <stdint.h>
+#include <sys/epoll.h>
+
+// event loop เดียวของโปรแกรม: epoll รวม fd ของ GPIO, socket และ timerfd
+typedef void (*evloop_cb)(int fd,uint32_t events,void *ctx);
+
+int evloop_init(void);
+int evloop_add(int fd,uint32_t events,evloop_cb cb,void *ctx);
+void evloop_del(int fd);
+
+// ถูกเรียกทุกครั้งก่อนรอ event รอบถัดไป
+void evloop_set_prepare(void (*fn)(void));
+
+// วนรับ event จนกว่าจะเรียก evloop_stop()
+int evloop_run(void);
+void evloop_stop(void);
+
+// timer บน timerfd: ms = เวลาครั้งแรก, interval_ms = ซ้ำทุกๆ (0 = ครั้งเดียว)
+typedef struct evtimer evtimer_t;
+evtimer_t *evtimer_new(void (*cb)(void *ctx),void *ctx);
+void evtimer_arm(evtimer_t *t,int ms,int interval_ms);
+void evtimer_disarm(evtimer_t *t);
+int evtimer_armed(const evtimer_t *t);
+
+#endif
@@ -0,0 +1,110 @@
+#include "font.h"
+#include <stdio.h>
+#include <stddef.h>
+
+#ifndef NO_FREETYPE
+#include "glyph_cache.h"
+
+static FT_Library ft;
+static FT_Face face;
+#endif
+
+static font_stats_t stats;
+
+#ifdef FONT_ATLAS
+// ชนิดข้อมูลที่ font_atlas.h (ไฟล์ที่ generate) ใช้
+typedef struct {
+    uint32_t codepoint;
+    int16_t left, top, advance;
+    uint8_t width, height;
+    uint32_t offset;        // ตำแหน่งใน font_atlas_bits
+} font_atlas_glyph_t;
+
+typedef struct {
+    uint16_t px;
+    uint16_t count;
+    uint32_t first;         // index แรกใน font_atlas_glyphs (เรียงตาม codepoint)
+} font_atlas_size_t;
+
+#include "font_atlas.h"
+
+static const glyph_t *atlas_glyph(int px,uint32_t cp){
+    static glyph_t g;
+    for(size_t i=0;i<sizeof(font_atlas_sizes)/sizeof(font_atlas_sizes[0]);i++){
+        if(font_atlas_sizes[i].px!=px) continue;
+
+        const font_atlas_glyph_t *tab=&font_atlas_glyphs[font_atlas_sizes[i].first];
+        int lo=0, hi=font_atlas_sizes[i].count-1;
+        while(lo<=hi){
+            int mid=(lo+hi)/2;
+            if(tab[mid].codepoint==cp){
+                g.left=tab[mid].left; g.top=tab[mid].top; g.advance=tab[mid].advance;
+                g.width=tab[mid].width; g.height=tab[mid].height;
+                g.bits=&font_atlas_bits[tab[mid].offset];
+                return &g;
+            }
+            if(tab[mid].codepoint<cp) lo=mid+1; else hi=mid-1;
+        }
+        return NULL;
+    }
+    return NULL;
+}
+#endif
+
+int font_init(const char *path){
+#ifndef NO_FREETYPE
+    if(FT_Init_FreeType(&ft)){ fprintf(stderr,"Could not init FreeType\n"); return -1; }
+    if(FT_New_Face(ft,path,0,&face)){
+        face=NULL;
+#ifdef FONT_ATLAS
+        fprintf(stderr,"Failed to load font %s, using built-in atlas only\n",path);
+        return 0;
+#else
+        fprintf(stderr,"Failed to load font\n");
+        return -1;
+#endif
+    }
+#else
+    (void)path;
+#endif
+    return 0;
+}
+
+void font_done(void){
+#ifndef NO_FREETYPE
+    glyph_cache_clear();
+    if(face) FT_Done_Face(face);
+    if(ft) FT_Done_FreeType(ft);
+    face=NULL; ft=NULL;
+#endif
+}
+
+const glyph_t *font_glyph(int px,uint32_t cp){
+#ifdef FONT_ATLAS
+    const glyph_t *g=atlas_glyph(px,cp);
+    if(g){ stats.atlas_hits++; return g; }
+#endif
+#ifndef NO_FREETYPE
+    if(face) return glyph_cache_get(face,px,cp);
+#endif
+    return NULL;
+}
+
+void font_get_stats(font_stats_t *st){
+    *st=stats;
+#ifndef NO_FREETYPE
+    glyph_cache_stats_t cs;
+    glyph_cache_get_stats(&cs);
+    st->cache_hits=cs.hits;
+    st->cache_misses=cs.misses;
+#endif
+}
+
+int font_preload(int px,const char *text){
+    int missing=0;
+    while(*text){
+        uint32_t cp=font_utf8_next(&text);
+        if(cp && !font_glyph(px,cp)) missing++;
+    }
+    return missing;
+}
@@ -0,0 +1,58 @@
+#ifndef FONT_H
+#define FONT_H
+
+#include <stdint.h>
+
+// แหล่ง glyph ที่ใช้ได้ (เลือกตอน build):
+//   -DFONT_ATLAS   ใช้ atlas ที่ bake ไว้ใน font_atlas.h (สร้างด้วย tools/fontbake)
+//   -DNO_FREETYPE  ไม่ link FreeType เลย (ต้องมี FONT_ATLAS)
+// ถ้ามีทั้งสองแบบ codepoint/ขนาดที่ไม่อยู่ใน atlas จะไปโหลดผ่าน FreeType แทน
+#if defined(NO_FREETYPE) && !defined(FONT_ATLAS)
+#error "NO_FREETYPE requires FONT_ATLAS"
+#endif
+
+// glyph แบบ 1bpp เรียงตาม page ของ SSD1306:
+// (height+7)/8 แถว แถวละ width byte, bit0 ของแต่ละ byte คือ pixel บนสุดของแถวนั้น
+typedef struct {
+    int16_t left;           // ระยะจากจุดเริ่มถึงขอบซ้ายของ bitmap
+    int16_t top;            // ระยะจาก baseline ขึ้นไปถึงขอบบนของ bitmap
+    int16_t advance;        // ระยะเลื่อนไปตัวถัดไป (pixel)
+    uint8_t width;
+    uint8_t height;
+    const uint8_t *bits;
+} glyph_t;
+
+typedef struct {
+    uint32_t atlas_hits;
+    uint32_t cache_hits;
+    uint32_t cache_misses;  // ครั้งที่ต้องเรียก FreeType
+} font_stats_t;
+
+// เปิดฟอนต์ (ถ้ามี atlas แล้วเปิดไฟล์ไม่ได้จะแค่เตือน) คืน 0 ถ้าพร้อมใช้งาน
+int font_init(const char *path);
+void font_done(void);
+
+// คืน glyph ของ codepoint ที่ขนาด px หรือ NULL ถ้าไม่มี
+// pointer ใช้ได้จนกว่าจะเรียก font_glyph ครั้งถัดไป
+const glyph_t *font_glyph(int px,uint32_t codepoint);
+
+void font_get_stats(font_stats_t *st);
+
+// โหลด glyph ทุกตัวของข้อความไว้ก่อน (ตอนเริ่มโปรแกรม ให้การกดปุ่มครั้งแรกไม่ต้องรอ FreeType)
+// คืนจำนวน glyph ที่ไม่มีในฟอนต์
+int font_preload(int px,const char *text);
+
+// อ่าน codepoint ถัดไปของ UTF-8 แล้วเลื่อน *s คืน 0 ถ้าเป็น byte ที่ไม่ถูกต้อง (ข้ามไป 1 byte)
+static inline uint32_t font_utf8_next(const char **s){
+    const unsigned char *p=(const unsigned char*)*s;
+    uint32_t cp=0;
+    int len=1;
+    if(p[0]<0x80) cp=p[0];
+    else if((p[0]&0xE0)==0xC0){ cp=((p[0]&0x1F)<<6)|(p[1]&0x3F); len=2; }
+    else if((p[0]&0xF0)==0xE0){ cp=((p[0]&0x0F)<<12)|((p[1]&0x3F)<<6)|(p[2]&0x3F); len=3; }
+    else if((p[0]&0xF8)==0xF0){ cp=((p[0]&0x07)<<18)|((p[1]&0x3F)<<12)|((p[2]&0x3F)<<6)|(p[3]&0x3F); len=4; }
+    *s+=len;
+    return cp;
+}
+
+#endif
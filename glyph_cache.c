@@ -0,0 +1,133 @@
+#include "glyph_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GLYPH_CACHE_BUCKETS 256
+
+typedef struct entry {
+    struct entry *hnext;                // chain ใน hash bucket
+    struct entry *prev, *next;          // LRU list (head = ใช้ล่าสุด)
+    FT_Face face;
+    int px;
+    uint32_t codepoint;
+    size_t cost;
+    glyph_t glyph;
+    uint8_t bits[];
+} entry_t;
+
+static entry_t *buckets[GLYPH_CACHE_BUCKETS];
+static entry_t *lru_head, *lru_tail;
+static glyph_cache_stats_t stats;
+
+// ขนาดที่ตั้งให้ face ไว้ล่าสุด เรียก FT_Set_Pixel_Sizes เฉพาะตอนเปลี่ยนขนาด
+static FT_Face sized_face;
+static int sized_px;
+
+static unsigned hash_key(FT_Face face,int px,uint32_t cp){
+    uintptr_t h=(uintptr_t)face;
+    h^=(h>>7);
+    h=h*31+(unsigned)px;
+    h=h*2654435761u+cp;
+    return (unsigned)(h^(h>>13))&(GLYPH_CACHE_BUCKETS-1);
+}
+
+static void lru_unlink(entry_t *e){
+    if(e->prev) e->prev->next=e->next; else lru_head=e->next;
+    if(e->next) e->next->prev=e->prev; else lru_tail=e->prev;
+    e->prev=e->next=NULL;
+}
+
+static void lru_push_front(entry_t *e){
+    e->prev=NULL;
+    e->next=lru_head;
+    if(lru_head) lru_head->prev=e; else lru_tail=e;
+    lru_head=e;
+}
+
+static void remove_entry(entry_t *e){
+    entry_t **pp=&buckets[hash_key(e->face,e->px,e->codepoint)];
+    while(*pp && *pp!=e) pp=&(*pp)->hnext;
+    if(*pp) *pp=e->hnext;
+    lru_unlink(e);
+    stats.bytes-=e->cost;
+    stats.entries--;
+    free(e);
+}
+
+// render ด้วย FreeType แล้วแปลงเป็น 1bpp (threshold เดียวกับของเดิม > 128)
+static entry_t *load_glyph(FT_Face face,int px,uint32_t cp){
+    if(face!=sized_face || px!=sized_px){
+        FT_Set_Pixel_Sizes(face,0,px);
+        sized_face=face; sized_px=px;
+    }
+
+    int w=0, h=0;
+    FT_GlyphSlot g=NULL;
+    if(FT_Load_Char(face,cp,FT_LOAD_RENDER)==0){
+        g=face->glyph;
+        w=g->bitmap.width; h=g->bitmap.rows;
+        if(w>255) w=255;
+        if(h>255) h=255;
+    }
+    // โหลดไม่ได้ก็เก็บเป็น glyph ว่าง จะได้ไม่ต้องถาม FreeType ซ้ำ
+
+    size_t nbits=(size_t)w*((h+7)/8);
+    entry_t *e=calloc(1,sizeof(entry_t)+nbits);
+    if(!e) return NULL;
+    e->face=face; e->px=px; e->codepoint=cp;
+    e->cost=sizeof(entry_t)+nbits;
+    e->glyph.bits=e->bits;
+    if(g){
+        e->glyph.left=g->bitmap_left;
+        e->glyph.top=g->bitmap_top;
+        e->glyph.advance=g->advance.x>>6;
+        e->glyph.width=w;
+        e->glyph.height=h;
+        for(int row=0;row<h;row++){
+            const uint8_t *src=&g->bitmap.buffer[row*g->bitmap.pitch];
+            uint8_t *dst=&e->bits[(row/8)*w];
+            uint8_t bit=1<<(row%8);
+            for(int col=0;col<w;col++){
+                if(src[col]>128) dst[col]|=bit;
+            }
+        }
+    }
+    return e;
+}
+
+const glyph_t *glyph_cache_get(FT_Face face,int px,uint32_t cp){
+    unsigned b=hash_key(face,px,cp);
+    for(entry_t *e=buckets[b];e;e=e->hnext){
+        if(e->codepoint==cp && e->px==px && e->face==face){
+            stats.hits++;
+            if(e!=lru_head){ lru_unlink(e); lru_push_front(e); }
+            return &e->glyph;
+        }
+    }
+
+    stats.misses++;
+    entry_t *e=load_glyph(face,px,cp);
+    if(!e) return NULL;
+
+    // ทิ้งตัวที่ไม่ได้ใช้นานที่สุดจนกว่าจะอยู่ในงบ
+    while(lru_tail && stats.bytes+e->cost>GLYPH_CACHE_BUDGET){
+        remove_entry(lru_tail);
+        stats.evictions++;
+    }
+
+    e->hnext=buckets[b];
+    buckets[b]=e;
+    lru_push_front(e);
+    stats.bytes+=e->cost;
+    stats.entries++;
+    return &e->glyph;
+}
+
+void glyph_cache_clear(void){
+    while(lru_head) remove_entry(lru_head);
+    sized_face=NULL;
+    sized_px=0;
+}
+
+void glyph_cache_get_stats(glyph_cache_stats_t *st){ *st=stats; }
@@ -0,0 +1,29 @@
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include "font.h"
+
+// งบหน่วยความจำของ cache (byte) เกินแล้วจะทิ้ง glyph ที่ไม่ได้ใช้นานที่สุด (LRU)
+#ifndef GLYPH_CACHE_BUDGET
+#define GLYPH_CACHE_BUDGET (16*1024)
+#endif
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    uint32_t entries;
+    size_t bytes;
+} glyph_cache_stats_t;
+
+// คืน glyph ของ codepoint ที่ขนาด px (pixel) โหลดผ่าน FreeType เฉพาะตอน miss
+// pointer ใช้ได้จนกว่าจะเรียก glyph_cache_get ครั้งถัดไป
+const glyph_t *glyph_cache_get(FT_Face face,int px,uint32_t codepoint);
+void glyph_cache_clear(void);
+void glyph_cache_get_stats(glyph_cache_stats_t *st);
+
+#endif
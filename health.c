@@ -0,0 +1,415 @@
+#include "health.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+
+// seqlock: thread ping เขียนคนเดียว ผู้อ่านอ่านซ้ำถ้า seq เป็นเลขคี่ (กำลังเขียน) หรือเปลี่ยนระหว่างอ่าน
+// ตัวข้อมูลคัดลอกทีละ word แบบ atomic relaxed จึงไม่เป็น data race ตามมาตรฐาน
+#define HEALTH_WORDS (sizeof(monitor_health_t)/sizeof(uint32_t))
+_Static_assert(sizeof(monitor_health_t)%sizeof(uint32_t)==0,"monitor_health_t must be whole words");
+
+struct slot {
+    atomic_uint seq;
+    _Atomic uint32_t gen;           // ชุดปลายทางที่สถิตินี้เป็นของ (ดู struct target_set)
+    _Atomic uint32_t w[HEALTH_WORDS];
+};
+
+static struct slot slots[MONITOR_MAX];
+static monitor_health_t cur[MONITOR_MAX];  // สำเนาของ thread ping เอง
+static int use_seq;
+
+// ปลายทางของ ping แบบ RCU: main thread สร้างชุดใหม่ทั้งชุดแล้วสลับ pointer (ไม่แก้ชุดที่ thread ping ถืออยู่)
+// thread ping โหลด pointer ใหม่ทุกรอบแล้วนับ quiescent ชุดเก่าคืน memory ได้เมื่อ quiescent เดินไปแล้ว 2 ครั้ง
+// (ครั้งที่สองแปลว่า thread โหลด pointer หลังการสลับแล้วแน่นอน)
+struct target_set {
+    int n;
+    struct sockaddr_in addr[MONITOR_MAX];
+    uint32_t gen[MONITOR_MAX];      // เปลี่ยนเมื่อ address ของช่องนั้นเปลี่ยน -> thread ping ล้างสถิติของช่อง
+    struct target_set *retired;     // รายการชุดเก่าที่รอคืน memory (main thread เท่านั้น)
+    uint64_t retired_at;
+};
+static _Atomic(struct target_set *) targets;
+static atomic_uint_fast64_t quiescent;
+static struct target_set *retired;
+static uint32_t next_gen;
+static atomic_int ntargets;     // = targets->n สำหรับตรวจ idx จาก thread อื่นโดยไม่แตะ pointer
+static _Atomic uint32_t want_gen[MONITOR_MAX];  // = targets->gen ด้วยเหตุผลเดียวกัน
+
+// ของ thread ping เท่านั้น
+static const struct target_set *snap;
+static uint32_t snap_gen[MONITOR_MAX];
+static int snap_n;
+
+static int sock = -1;
+static int event_fd = -1;       // แจ้ง main loop ว่าสถานะเปลี่ยน
+static int wake_fd = -1;        // ปลุก thread ให้เลิก
+static int kick_fd = -1;        // มี lease ใหม่ ให้ thread ตรวจ lease ทันที
+
+// lease จาก heartbeat (us, CLOCK_MONOTONIC) เขียนจาก thread อื่น thread ping อ่านอย่างเดียว
+static _Atomic int64_t lease_until[MONITOR_MAX];
+static _Atomic int64_t last_push[MONITOR_MAX];
+static atomic_int running;
+static pthread_t probe_thread;
+
+static int64_t now_us(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (int64_t)ts.tv_sec*1000000+ts.tv_nsec/1000;
+}
+
+static void publish(int i){
+    struct slot *s=&slots[i];
+    unsigned seq=atomic_load_explicit(&s->seq,memory_order_relaxed);
+    atomic_store_explicit(&s->seq,seq+1,memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    uint32_t w[HEALTH_WORDS];
+    memcpy(w,&cur[i],sizeof(w));
+    atomic_store_explicit(&s->gen,snap_gen[i],memory_order_relaxed);
+    for(size_t k=0;k<HEALTH_WORDS;k++) atomic_store_explicit(&s->w[k],w[k],memory_order_relaxed);
+    atomic_store_explicit(&s->seq,seq+2,memory_order_release);
+}
+
+int health_get(int idx,monitor_health_t *out){
+    if(idx<0 || idx>=ntargets) return -1;
+    struct slot *s=&slots[idx];
+    uint32_t w[HEALTH_WORDS],gen;
+    unsigned s1,s2;
+    do {
+        s1=atomic_load_explicit(&s->seq,memory_order_acquire);
+        gen=atomic_load_explicit(&s->gen,memory_order_relaxed);
+        for(size_t k=0;k<HEALTH_WORDS;k++) w[k]=atomic_load_explicit(&s->w[k],memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        s2=atomic_load_explicit(&s->seq,memory_order_relaxed);
+    } while((s1&1) || s1!=s2);
+    // address เพิ่งเปลี่ยน thread ping ยังไม่ได้ล้างช่อง: ยังไม่มีข้อมูลของ address ใหม่
+    if(gen!=atomic_load(&want_gen[idx])) memset(w,0,sizeof(w));
+    memcpy(out,w,sizeof(*out));
+    return 0;
+}
+
+int health_event_fd(void){ return event_fd; }
+
+static void notify(void){
+    uint64_t one=1;
+    if(write(event_fd,&one,sizeof(one))<0 && errno!=EAGAIN) perror("health notify");
+}
+
+void health_heartbeat(int idx,int lease_ms){
+    if(idx<0 || idx>=ntargets) return;
+    int64_t now=now_us();
+    atomic_store(&last_push[idx],now);
+    int64_t prev=atomic_exchange(&lease_until[idx],now+(int64_t)lease_ms*1000);
+    // ต่อ lease เดิมไม่ต้องปลุก: thread จะเห็นค่าใหม่ตอนตื่นมาตรวจ lease เดิมที่หมดเวลา
+    if(prev<=now){
+        uint64_t one=1;
+        if(write(kick_fd,&one,sizeof(one))<0 && errno!=EAGAIN) perror("health kick");
+    }
+}
+
+// thread ping: รับชุดปลายทางล่าสุด ช่องที่ address เปลี่ยน/เพิ่มใหม่เริ่มนับสถิติใหม่ (ไม่ใช้ RTT ของ address เดิม)
+// คืน 1 ถ้าชุดเปลี่ยน
+static int sync_targets(void){
+    const struct target_set *t=atomic_load(&targets);
+    int changed=t!=snap;
+    if(changed){
+        for(int i=0;i<t->n;i++){
+            if(i<snap_n && t->gen[i]==snap_gen[i]) continue;
+            int was_up=cur[i].up;
+            memset(&cur[i],0,sizeof(cur[i]));
+            snap_gen[i]=t->gen[i];
+            publish(i);
+            if(was_up) notify();
+        }
+        snap=t;
+        snap_n=t->n;
+    }
+    atomic_fetch_add(&quiescent,1);     // ไม่ได้ถือชุดก่อนหน้าแล้ว
+    return changed;
+}
+
+// monitor ที่ถือ lease อยู่ถือว่า up, lease ที่หมดแล้วตัดเป็น down ทันทีไม่ต้องรอ ping
+// คืนเวลา (us) ที่ lease ถัดไปจะหมด หรือ -1 ถ้าไม่มี
+static int64_t check_leases(void){
+    int64_t now=now_us(),next=-1;
+    for(int i=0;i<snap_n;i++){
+        monitor_health_t *c=&cur[i];
+        int64_t until=atomic_load(&lease_until[i]);
+        int changed=0;
+        if(until>now){
+            if(next<0 || until<next) next=until;
+            changed=!c->up;
+            c->up=1;
+            c->pushed=1;
+            c->misses=0;
+            c->last_seen_ms=atomic_load(&last_push[i])/1000;
+            publish(i);
+        } else if(c->pushed){
+            changed=c->up;
+            c->up=0;
+            c->pushed=0;
+            c->misses=PROBE_DOWN_AFTER;
+            publish(i);
+        }
+        if(changed) notify();
+    }
+    return next;
+}
+
+static void on_reply(int i,int64_t rtt){
+    monitor_health_t *c=&cur[i];
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+
+    c->received++;
+    metrics_record(M_RTT,(uint64_t)rtt*1000);
+    c->last_seen_ms=(int64_t)ts.tv_sec*1000+ts.tv_nsec/1000000;
+    if(c->received==1){ c->srtt_us=rtt; c->rtt_min_us=rtt; }
+    else {
+        c->srtt_us=(uint32_t)((int64_t)c->srtt_us+(rtt-(int64_t)c->srtt_us)/8);
+        if(rtt<c->rtt_min_us) c->rtt_min_us=rtt;
+    }
+    c->loss_permille-=c->loss_permille/8;
+    c->misses=0;
+
+    int changed=!c->up;
+    c->up=1;
+    publish(i);
+    if(changed) notify();
+}
+
+static void on_miss(int i){
+    monitor_health_t *c=&cur[i];
+    c->loss_permille+=(1000-c->loss_permille)/8;
+    metrics_add(M_PROBE_LOSS,1);
+    if(c->misses<UINT16_MAX) c->misses++;
+
+    int changed=c->up && c->misses>=PROBE_DOWN_AFTER;
+    if(changed) c->up=0;
+    publish(i);
+    if(changed) notify();
+}
+
+// pong ต้องมาจาก address/port ของ monitor ที่ถูก ping และ (ถ้าใช้ seq) มีเลขของรอบนี้
+// pong ที่มาช้าจากรอบก่อน หรือ datagram อื่นๆ จะไม่ถูกนับ
+static int match_reply(const struct sockaddr_in *from,const char *buf,uint32_t round,const int *answered,int n){
+    if(use_seq){
+        unsigned long seq;
+        char *end;
+        if(strncmp(buf,"pong ",5)!=0) return -1;
+        seq=strtoul(buf+5,&end,10);
+        if(end==buf+5 || *end || seq!=round) return -1;
+    } else if(strcmp(buf,"pong")!=0){
+        return -1;
+    }
+    // monitor หลายตัวอาจใช้ address เดียวกัน: ให้ตัวแรกที่ยังไม่ได้คำตอบ
+    for(int i=0;i<n;i++){
+        if(!answered[i] && from->sin_addr.s_addr==snap->addr[i].sin_addr.s_addr && from->sin_port==snap->addr[i].sin_port)
+            return i;
+    }
+    return -1;
+}
+
+// ping ทุก monitor พร้อมกันแล้วรอคำตอบรวมไม่เกิน PROBE_TIMEOUT_MS คืน -1 ถ้าถูกสั่งหยุด
+static int probe_round(uint32_t round){
+    int64_t sent_at[MONITOR_MAX];
+    int answered[MONITOR_MAX]={0};
+    char msg[32];
+    int len;
+
+    if(use_seq) len=snprintf(msg,sizeof(msg),"ping %u",round);
+    else len=snprintf(msg,sizeof(msg),"ping");
+
+    sync_targets();                     // ชุดที่เปลี่ยนระหว่างรอบนี้ใช้รอบหน้า
+    check_leases();
+    int n=snap_n;
+    for(int i=0;i<n;i++){
+        sent_at[i]=now_us();
+        if(cur[i].pushed){ answered[i]=2; continue; }   // มี heartbeat อยู่ ไม่ต้อง ping
+        if(sendto(sock,msg,len,0,(const struct sockaddr*)&snap->addr[i],sizeof(snap->addr[i]))<0)
+            answered[i]=-1;             // ส่งไม่ออก (เช่น network ยังไม่ขึ้น) นับเป็นหาย
+        else { cur[i].sent++; metrics_add(M_PROBES,1); }
+    }
+
+    int left=0;
+    for(int i=0;i<n;i++) if(!answered[i]) left++;
+
+    int64_t deadline=now_us()+PROBE_TIMEOUT_MS*1000;
+    while(left>0){
+        int64_t wait=deadline-now_us();
+        if(wait<=0) break;
+
+        struct pollfd p[2]={ { sock, POLLIN, 0 }, { wake_fd, POLLIN, 0 } };
+        int r=poll(p,2,(int)((wait+999)/1000));
+        if(r<0){
+            if(errno==EINTR) continue;
+            perror("health poll");
+            break;
+        }
+        if(p[1].revents) return -1;
+        if(!p[0].revents) continue;
+
+        for(;;){
+            char buf[32];
+            struct sockaddr_in from;
+            socklen_t fl=sizeof(from);
+            ssize_t got=recvfrom(sock,buf,sizeof(buf)-1,0,(struct sockaddr*)&from,&fl);
+            if(got<0) break;
+            buf[got]=0;
+            if(got>0 && buf[got-1]=='\n') buf[got-1]=0;
+
+            int i=match_reply(&from,buf,round,answered,snap_n);
+            if(i<0) continue;
+            answered[i]=1;
+            left--;
+            on_reply(i,now_us()-sent_at[i]);
+        }
+    }
+
+    for(int i=0;i<n;i++) if(!answered[i] || answered[i]<0) on_miss(i);
+    return 0;
+}
+
+static void *probe_main(void *arg){
+    (void)arg;
+    uint32_t round=0;
+    while(atomic_load(&running)){
+        int64_t start=now_us();
+        if(probe_round(++round)<0) break;
+
+        // รอรอบถัดไป ระหว่างนี้ตื่นมาตัด lease ที่หมดเวลา และรับ lease ใหม่
+        int64_t due=start+PROBE_INTERVAL_MS*1000;
+        for(;;){
+            if(sync_targets()) break;   // monitor ใหม่/address ใหม่: ping ทันทีไม่รอรอบ
+            int64_t next=check_leases();
+            int64_t now=now_us();
+            if(now>=due) break;
+            if(next<0 || next>due) next=due;
+
+            struct pollfd p[2]={ { wake_fd, POLLIN, 0 }, { kick_fd, POLLIN, 0 } };
+            int r=poll(p,2,(int)((next-now+999)/1000));
+            if(r<0 && errno!=EINTR){ perror("health poll"); break; }
+            if(r>0 && p[0].revents) return NULL;
+            if(r>0 && p[1].revents){
+                uint64_t n;
+                if(read(kick_fd,&n,sizeof(n))<0 && errno!=EAGAIN) perror("health kick");
+            }
+        }
+    }
+    return NULL;
+}
+
+// main thread: คืน memory ของชุดเก่าที่ thread ping เลิกใช้แน่นอนแล้ว
+static void reclaim(int all){
+    uint64_t q=atomic_load(&quiescent);
+    struct target_set **p=&retired;
+    while(*p){
+        struct target_set *t=*p;
+        if(all || q>=t->retired_at+2){ *p=t->retired; free(t); }
+        else p=&t->retired;
+    }
+}
+
+// สร้างชุดใหม่จากชุดปัจจุบัน (ให้ผู้เรียกแก้) คืน NULL ถ้า memory ไม่พอ
+static struct target_set *copy_targets(void){
+    struct target_set *t=malloc(sizeof(*t));
+    if(!t){ perror("health"); return NULL; }
+    const struct target_set *old=atomic_load(&targets);
+    if(old) memcpy(t,old,sizeof(*t));
+    else memset(t,0,sizeof(*t));
+    t->retired=NULL;
+    return t;
+}
+
+static void set_target(struct target_set *t,int i,const struct sockaddr_in *addr){
+    t->addr[i]=*addr;
+    if(++next_gen==0) next_gen=1;   // gen 0 = ช่องที่ thread ping ยังไม่เคยเห็น
+    t->gen[i]=next_gen;
+    atomic_store(&want_gen[i],next_gen);
+    atomic_store(&lease_until[i],0);
+}
+
+static void swap_targets(struct target_set *t){
+    struct target_set *old=atomic_exchange(&targets,t);
+    atomic_store(&ntargets,t->n);
+    if(old){
+        old->retired_at=atomic_load(&quiescent);
+        old->retired=retired;
+        retired=old;
+    }
+    reclaim(0);
+    if(atomic_load(&running)){
+        uint64_t one=1;     // ปลุก thread ping ให้รับชุดใหม่ทันที
+        if(write(kick_fd,&one,sizeof(one))<0 && errno!=EAGAIN) perror("health kick");
+    }
+}
+
+int health_start(const struct sockaddr_in *addrs,int n,int seq){
+    if(n<0 || n>MONITOR_MAX){ fprintf(stderr,"health: bad monitor count %d\n",n); return -1; }
+
+    use_seq=seq;
+    memset(cur,0,sizeof(cur));
+    struct target_set *t=copy_targets();
+    if(!t) return -1;
+    for(int i=0;i<n;i++) set_target(t,i,&addrs[i]);
+    t->n=n;
+    swap_targets(t);
+
+    sock=socket(AF_INET,SOCK_DGRAM|SOCK_NONBLOCK|SOCK_CLOEXEC,0);
+    if(sock<0){ perror("health socket"); return -1; }
+    event_fd=eventfd(0,EFD_NONBLOCK|EFD_CLOEXEC);
+    wake_fd=eventfd(0,EFD_NONBLOCK|EFD_CLOEXEC);
+    kick_fd=eventfd(0,EFD_NONBLOCK|EFD_CLOEXEC);
+    if(event_fd<0 || wake_fd<0 || kick_fd<0){ perror("health eventfd"); return -1; }
+
+    atomic_store(&running,1);
+    if(pthread_create(&probe_thread,NULL,probe_main,NULL)!=0){
+        perror("health thread");
+        atomic_store(&running,0);
+        return -1;
+    }
+    return 0;
+}
+
+int health_add(const struct sockaddr_in *addr){
+    int i=atomic_load(&ntargets);
+    if(i>=MONITOR_MAX) return -1;
+    struct target_set *t=copy_targets();
+    if(!t) return -1;
+    set_target(t,i,addr);
+    t->n=i+1;
+    swap_targets(t);
+    return i;
+}
+
+int health_update(const struct sockaddr_in *addrs,int n){
+    if(n<0 || n>MONITOR_MAX) return -1;
+    struct target_set *t=copy_targets();
+    if(!t) return -1;
+    for(int i=0;i<n;i++){
+        if(i<t->n && t->addr[i].sin_addr.s_addr==addrs[i].sin_addr.s_addr && t->addr[i].sin_port==addrs[i].sin_port)
+            continue;
+        set_target(t,i,&addrs[i]);
+    }
+    t->n=n;
+    swap_targets(t);
+    return 0;
+}
+
+void health_stop(void){
+    if(!atomic_exchange(&running,0)) return;
+    uint64_t one=1;
+    if(write(wake_fd,&one,sizeof(one))<0) perror("health wake");
+    pthread_join(probe_thread,NULL);
+    close(sock);
+    sock=-1;
+    reclaim(1);
+}
@@ -0,0 +1,53 @@
+#ifndef HEALTH_H
+#define HEALTH_H
+
+#include <stdint.h>
+#include <netinet/in.h>
+#include "monitors.h"
+
+#ifndef PROBE_INTERVAL_MS
+#define PROBE_INTERVAL_MS 1000  // ping ทุก monitor พร้อมกันทุกๆ เท่านี้
+#endif
+#ifndef PROBE_TIMEOUT_MS
+#define PROBE_TIMEOUT_MS 500    // pong ที่มาช้ากว่านี้นับว่าหาย
+#endif
+#ifndef PROBE_DOWN_AFTER
+#define PROBE_DOWN_AFTER 2      // หายติดกันกี่ครั้งถึงถือว่าหลุด (กันสถานะกระพริบ)
+#endif
+
+// สถานะล่าสุดของ monitor หนึ่งตัว (สำเนา อ่านได้ทันทีไม่ต้องรอ network)
+typedef struct {
+    int up;                  // 1 = ตอบ pong หรือยังอยู่ใน lease ของ heartbeat
+    int pushed;              // 1 = monitor ส่ง heartbeat มาเอง (ระหว่างนี้ไม่ต้อง ping)
+    int64_t last_seen_ms;    // CLOCK_MONOTONIC ของ pong/heartbeat ล่าสุด (0 = ยังไม่เคยตอบ)
+    uint32_t srtt_us;        // RTT แบบ smoothed (EWMA 1/8)
+    uint32_t rtt_min_us;
+    uint16_t loss_permille;  // สัดส่วน probe ที่หาย (EWMA 1/8, 0-1000)
+    uint16_t misses;         // หายติดกันกี่ครั้งล่าสุด
+    uint32_t sent;
+    uint32_t received;
+} monitor_health_t;
+
+// เริ่ม thread ping ของตัวเอง (socket แยกจากที่ใช้ส่งคำสั่ง)
+// use_seq = 0 ส่ง "ping" เฉยๆ สำหรับ monitor รุ่นเก่าที่ตอบได้แค่ "pong"
+// n = 0 ได้ (ยังไม่มี monitor รอ health_add)
+int health_start(const struct sockaddr_in *addrs,int n,int use_seq);
+
+// เพิ่ม monitor ระหว่างทำงาน (จาก main thread) ถูก ping ทันที คืน index หรือ -1
+int health_add(const struct sockaddr_in *addr);
+// แทนรายการทั้งหมด (config ใหม่ จาก main thread) ช่องที่ address เดิมเก็บสถิติไว้
+// ช่องที่ address เปลี่ยนเริ่มนับใหม่ รอบ ping ที่กำลังรอคำตอบอยู่จบด้วยรายการเดิม
+int health_update(const struct sockaddr_in *addrs,int n);
+void health_stop(void);
+
+// อ่านสถานะที่ cache ไว้ (ไม่มี lock ไม่ block) คืน -1 ถ้า idx ผิด
+int health_get(int idx,monitor_health_t *out);
+
+// monitor แจ้งว่ายังอยู่: ถือว่า up ไปอีก lease_ms โดยไม่ ping ถ้าไม่มี heartbeat ใหม่ภายในเวลานั้น
+// จะถูกตัดเป็น down ทันทีแล้วกลับไปใช้ ping ตามปกติ เรียกจาก thread ไหนก็ได้
+void health_heartbeat(int idx,int lease_ms);
+
+// eventfd ที่อ่านได้เมื่อ monitor ตัวใดเปลี่ยน up/down ให้ main loop ไปอ่าน health_get ใหม่
+int health_event_fd(void);
+
+#endif
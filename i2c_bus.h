@@ -0,0 +1,20 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <stdint.h>
+#include <linux/i2c.h>
+
+// บัส I2C ที่ driver OLED ส่งข้อมูลผ่าน เลือก backend ตอน link (make I2C=dev|mem):
+//   i2c_dev.c  /dev/i2c-N จริง (I2C_RDWR หลาย message ต่อ ioctl, ถอยไปใช้ write() ถ้าไม่รองรับ)
+//   i2c_mem.c  จำลองใน memory: นับ byte/transaction และจำลอง GDDRAM ของ SSD1306 (ดู i2c_mem.h)
+typedef struct i2c_bus i2c_bus_t;
+
+// addr = address ของอุปกรณ์ (7 bit) คืน NULL ถ้าเปิดไม่ได้
+i2c_bus_t *i2c_bus_open(const char *path,uint16_t addr);
+
+// ส่ง message ทั้งหมดเป็น transaction เดียว (repeated start ระหว่าง message) คืน -1 ถ้าผิดพลาด
+int i2c_bus_xfer(i2c_bus_t *bus,struct i2c_msg *msgs,int n);
+
+void i2c_bus_close(i2c_bus_t *bus);
+
+#endif
@@ -0,0 +1,43 @@
+#include "i2c_bus.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+
+struct i2c_bus {
+    int fd;
+    int use_rdwr;               // adapter รองรับ I2C_RDWR (plain I2C)
+};
+
+i2c_bus_t *i2c_bus_open(const char *path,uint16_t addr){
+    i2c_bus_t *b=calloc(1,sizeof(*b));
+    if(!b) return NULL;
+    if((b->fd=open(path,O_RDWR|O_CLOEXEC))<0){ perror("i2c open"); free(b); return NULL; }
+    if(ioctl(b->fd,I2C_SLAVE,addr)<0){ perror("i2c ioctl"); close(b->fd); free(b); return NULL; }
+
+    unsigned long funcs=0;
+    b->use_rdwr = ioctl(b->fd,I2C_FUNCS,&funcs)==0 && (funcs&I2C_FUNC_I2C);
+    return b;
+}
+
+// ส่งหลาย message ใน ioctl เดียว (repeated start ระหว่าง message)
+// ถ้า adapter ไม่รองรับ I2C_RDWR จะถอยไปใช้ write() ทีละ message
+int i2c_bus_xfer(i2c_bus_t *b,struct i2c_msg *msgs,int n){
+    if(b->use_rdwr){
+        struct i2c_rdwr_ioctl_data xfer={ .msgs=msgs, .nmsgs=n };
+        if(ioctl(b->fd,I2C_RDWR,&xfer)<0){ perror("i2c rdwr"); return -1; }
+        return 0;
+    }
+    for(int i=0;i<n;i++){
+        if(write(b->fd,msgs[i].buf,msgs[i].len)!=msgs[i].len){ perror("i2c write"); return -1; }
+    }
+    return 0;
+}
+
+void i2c_bus_close(i2c_bus_t *b){
+    if(!b) return;
+    close(b->fd);
+    free(b);
+}
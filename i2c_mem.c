@@ -0,0 +1,180 @@
+#include "i2c_mem.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+struct i2c_bus {
+    uint16_t addr;
+    uint32_t clock_hz;
+    pthread_mutex_t lock;               // flush thread เขียน, benchmark/harness อ่าน
+    i2c_mem_stats_t stats;
+
+    // สถานะของ SSD1306 ที่จำลอง
+    uint8_t gddram[I2C_MEM_PAGES*I2C_MEM_WIDTH];
+    uint8_t mode;                       // 0 = horizontal, 2 = page addressing
+    uint8_t col_lo, col_hi, page_lo, page_hi;
+    uint8_t col, page;
+
+    int capture_fd;                     // I2C_MEM_CAPTURE: ส่ง GDDRAM ทุก xfer ที่มีข้อมูล (-1 = ปิด)
+    uint32_t frame_seq;
+};
+
+static int capture_open(const char *path){
+    struct sockaddr_un a;
+    memset(&a,0,sizeof(a));
+    a.sun_family=AF_UNIX;
+    if(strlen(path)>=sizeof(a.sun_path)){ fprintf(stderr,"i2c mem: capture path too long\n"); return -1; }
+    strcpy(a.sun_path,path);
+    int fd=socket(AF_UNIX,SOCK_DGRAM|SOCK_CLOEXEC,0);
+    if(fd<0){ perror("i2c mem capture"); return -1; }
+    if(connect(fd,(struct sockaddr*)&a,sizeof(a))<0){
+        perror("i2c mem capture");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static i2c_bus_t *last;
+
+i2c_bus_t *i2c_bus_open(const char *path,uint16_t addr){
+    (void)path;
+    i2c_bus_t *b=calloc(1,sizeof(*b));
+    if(!b) return NULL;
+    pthread_mutex_init(&b->lock,NULL);
+    b->addr=addr;
+    b->mode=2;                          // ค่าหลัง reset ของ SSD1306
+    b->col_hi=I2C_MEM_WIDTH-1;
+    b->page_hi=I2C_MEM_PAGES-1;
+    const char *env=getenv("I2C_MEM_CAPTURE");
+    b->capture_fd=env && *env ? capture_open(env) : -1;
+    if((env=getenv("I2C_MEM_CLOCK"))) b->clock_hz=strtoul(env,NULL,10);
+    last=b;
+    return b;
+}
+
+// จำนวน byte argument ของคำสั่ง SSD1306 ที่มี argument
+static int cmd_args(uint8_t c){
+    switch(c){
+    case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3: case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+        return 1;
+    case 0x21: case 0x22: case 0xA3:
+        return 2;
+    case 0x29: case 0x2A:
+        return 5;
+    case 0x26: case 0x27:
+        return 6;
+    }
+    return 0;
+}
+
+static void run_cmds(i2c_bus_t *b,const uint8_t *p,int n){
+    for(int i=0;i<n;){
+        uint8_t c=p[i++];
+        int na=cmd_args(c);
+        if(i+na>n) return;
+        const uint8_t *a=&p[i];
+        i+=na;
+        if(c==0x20) b->mode=a[0]&3;
+        else if(c==0x21){ b->col_lo=a[0]&0x7F; b->col_hi=a[1]&0x7F; b->col=b->col_lo; }
+        else if(c==0x22){ b->page_lo=a[0]&7; b->page_hi=a[1]&7; b->page=b->page_lo; }
+        else if(c>=0xB0 && c<=0xB7) b->page=c&7;
+        else if(c<=0x0F) b->col=(b->col&0xF0)|c;
+        else if(c>=0x10 && c<=0x1F) b->col=(b->col&0x0F)|((c&0x0F)<<4);
+    }
+}
+
+static void write_data(i2c_bus_t *b,const uint8_t *p,int n){
+    for(int i=0;i<n;i++){
+        b->gddram[b->page*I2C_MEM_WIDTH+b->col]=p[i];
+        b->stats.data_bytes++;
+        if(b->mode==2){                 // page mode: column วนอยู่ใน page เดิม
+            b->col=(b->col+1)&0x7F;
+            continue;
+        }
+        if(b->col<b->col_hi){ b->col++; continue; }
+        b->col=b->col_lo;
+        b->page=b->page<b->page_hi ? b->page+1 : b->page_lo;
+    }
+}
+
+int i2c_bus_xfer(i2c_bus_t *b,struct i2c_msg *msgs,int n){
+    uint64_t bytes=0;
+    pthread_mutex_lock(&b->lock);
+    uint64_t data0=b->stats.data_bytes;
+    b->stats.xfers++;
+    for(int i=0;i<n;i++){
+        const uint8_t *p=msgs[i].buf;
+        int len=msgs[i].len;
+        b->stats.transactions++;
+        b->stats.bytes+=len;
+        bytes+=len+1;                   // + address byte
+        if(msgs[i].addr!=b->addr || len<1) continue;
+        // control byte: bit6 = data, bit7 (Co) = มี control byte ตามทุก byte (driver นี้ไม่ใช้)
+        if(p[0]&0x40) write_data(b,p+1,len-1);
+        else run_cmds(b,p+1,len-1);
+    }
+    uint32_t hz=b->clock_hz;
+    uint64_t ns=hz ? bytes*9*1000000000ull/hz : 0;
+    b->stats.busy_ns+=ns;
+    int capture=b->capture_fd>=0 && b->stats.data_bytes!=data0;
+    i2c_mem_frame_t f;
+    if(capture){
+        memcpy(f.magic,I2C_MEM_FRAME_MAGIC,4);
+        f.seq=++b->frame_seq;
+        memcpy(f.gddram,b->gddram,sizeof(f.gddram));
+    }
+    pthread_mutex_unlock(&b->lock);
+
+    if(ns){
+        struct timespec ts={ (time_t)(ns/1000000000u), (long)(ns%1000000000u) };
+        nanosleep(&ts,NULL);
+    }
+    // เวลาที่ byte สุดท้ายออกจากบัส (หลังหน่วงตาม clock) ผู้รับช้า = ทิ้ง frame ไม่หน่วง flush
+    if(capture){
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC,&now);
+        f.ts=(uint64_t)now.tv_sec*1000000000u+now.tv_nsec;
+        send(b->capture_fd,&f,sizeof(f),MSG_DONTWAIT|MSG_NOSIGNAL);
+    }
+    return 0;
+}
+
+void i2c_bus_close(i2c_bus_t *b){
+    if(!b) return;
+    if(last==b) last=NULL;
+    if(b->capture_fd>=0) close(b->capture_fd);
+    pthread_mutex_destroy(&b->lock);
+    free(b);
+}
+
+i2c_bus_t *i2c_mem_last(void){ return last; }
+
+void i2c_mem_get_stats(i2c_bus_t *b,i2c_mem_stats_t *st){
+    pthread_mutex_lock(&b->lock);
+    *st=b->stats;
+    pthread_mutex_unlock(&b->lock);
+}
+
+void i2c_mem_reset_stats(i2c_bus_t *b){
+    pthread_mutex_lock(&b->lock);
+    memset(&b->stats,0,sizeof(b->stats));
+    pthread_mutex_unlock(&b->lock);
+}
+
+void i2c_mem_read_gddram(i2c_bus_t *b,uint8_t *out){
+    pthread_mutex_lock(&b->lock);
+    memcpy(out,b->gddram,sizeof(b->gddram));
+    pthread_mutex_unlock(&b->lock);
+}
+
+void i2c_mem_set_clock(i2c_bus_t *b,uint32_t hz){
+    pthread_mutex_lock(&b->lock);
+    b->clock_hz=hz;
+    pthread_mutex_unlock(&b->lock);
+}
@@ -0,0 +1,46 @@
+#ifndef I2C_MEM_H
+#define I2C_MEM_H
+
+#include <stdint.h>
+#include "i2c_bus.h"
+
+// backend I2C จำลอง (i2c_mem.c) สำหรับรันบนเครื่องอื่นที่ไม่ใช่ NanoPi และ benchmark
+// แปลงคำสั่ง/ข้อมูลที่ส่งไปเป็น GDDRAM ของ SSD1306 (8 page x 128 column) จึงตรวจได้ว่าบนจอมีอะไร
+
+#define I2C_MEM_WIDTH 128
+#define I2C_MEM_PAGES 8
+
+// ตัวแปร environment ตอน i2c_bus_open:
+//   I2C_MEM_CLOCK=400000        จำลองความเร็วบัส (เหมือน i2c_mem_set_clock)
+//   I2C_MEM_CAPTURE=<path>      ส่ง i2c_mem_frame_t ไปที่ Unix datagram socket นี้ทุก xfer ที่เขียน GDDRAM
+//                               (จอเสมือนให้ bench/e2e วัดเวลาจนถึงภาพบนจอ)
+#define I2C_MEM_FRAME_MAGIC "OLED"
+
+typedef struct {
+    char magic[4];
+    uint32_t seq;               // นับทุก frame ที่ส่ง (ผู้รับรู้ได้ว่า frame หาย)
+    uint64_t ts;                // ns ของ CLOCK_MONOTONIC ตอน xfer เสร็จ
+    uint8_t gddram[I2C_MEM_PAGES*I2C_MEM_WIDTH];
+} i2c_mem_frame_t;
+
+typedef struct {
+    uint64_t xfers;             // จำนวนครั้งที่เรียก i2c_bus_xfer
+    uint64_t transactions;      // message (start/repeated start)
+    uint64_t bytes;             // รวม control byte
+    uint64_t data_bytes;        // byte ที่เขียนลง GDDRAM
+    uint64_t busy_ns;           // เวลาบัสที่จำลอง (ถ้าตั้ง clock)
+} i2c_mem_stats_t;
+
+// บัสที่เปิดล่าสุด (driver OLED เก็บ handle ไว้เอง)
+i2c_bus_t *i2c_mem_last(void);
+
+void i2c_mem_get_stats(i2c_bus_t *bus,i2c_mem_stats_t *st);
+void i2c_mem_reset_stats(i2c_bus_t *bus);
+
+// สำเนา GDDRAM ปัจจุบัน (I2C_MEM_PAGES*I2C_MEM_WIDTH byte เรียงแบบ page)
+void i2c_mem_read_gddram(i2c_bus_t *bus,uint8_t *out);
+
+// จำลองความเร็วบัส: xfer ใช้เวลา 9 bit ต่อ byte ที่ hz นี้ (0 = ไม่หน่วง)
+void i2c_mem_set_clock(i2c_bus_t *bus,uint32_t hz);
+
+#endif
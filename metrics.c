@@ -0,0 +1,182 @@
+#define _GNU_SOURCE
+#include "metrics.h"
+#include "evloop.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/signalfd.h>
+#include <sys/un.h>
+
+static const char *hist_names[M_HISTS] = {
+    [M_GPIO]="gpio", [M_INPUT]="input", [M_RENDER]="render_text",
+    [M_FLUSH]="oled_flush", [M_SEND]="send", [M_RTT]="ping_rtt",
+};
+static const char *counter_names[M_COUNTERS] = {
+    [M_PRESSES]="presses", [M_DATAGRAMS]="datagrams", [M_PROBES]="probes",
+    [M_PROBE_LOSS]="probe_loss", [M_FRAMES]="oled_frames", [M_BUS_BYTES]="i2c_bytes",
+};
+
+struct hist {
+    _Atomic uint64_t count;
+    _Atomic uint64_t sum_ns;
+    _Atomic uint64_t max_ns;
+    _Atomic uint64_t buckets[METRICS_BUCKETS];
+};
+
+static struct hist hists[M_HISTS];
+static _Atomic uint64_t counters[M_COUNTERS];
+
+static int sig_fd = -1;
+static int listen_fd = -1;
+static char *sock_path;
+
+#ifndef NO_METRICS
+void metrics_record(metrics_hist_t h,uint64_t ns){
+    struct hist *s=&hists[h];
+    int b=63-__builtin_clzll(ns|1);
+    if(b>=METRICS_BUCKETS) b=METRICS_BUCKETS-1;
+    atomic_fetch_add_explicit(&s->buckets[b],1,memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->count,1,memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->sum_ns,ns,memory_order_relaxed);
+    uint64_t max=atomic_load_explicit(&s->max_ns,memory_order_relaxed);
+    while(ns>max && !atomic_compare_exchange_weak_explicit(&s->max_ns,&max,ns,memory_order_relaxed,memory_order_relaxed))
+        ;
+}
+
+void metrics_add(metrics_counter_t c,uint64_t n){
+    atomic_fetch_add_explicit(&counters[c],n,memory_order_relaxed);
+}
+#endif
+
+// ไม่ใช่ snapshot ที่ตรงกันทุกช่อง (ไม่มี lock) แต่ต่างกันได้แค่ค่าที่บันทึกระหว่างอ่าน
+void metrics_get(metrics_hist_t h,metrics_hist_snapshot_t *out){
+    struct hist *s=&hists[h];
+    out->count=atomic_load_explicit(&s->count,memory_order_relaxed);
+    out->sum_ns=atomic_load_explicit(&s->sum_ns,memory_order_relaxed);
+    out->max_ns=atomic_load_explicit(&s->max_ns,memory_order_relaxed);
+    for(int b=0;b<METRICS_BUCKETS;b++) out->buckets[b]=atomic_load_explicit(&s->buckets[b],memory_order_relaxed);
+}
+
+uint64_t metrics_counter(metrics_counter_t c){
+    return atomic_load_explicit(&counters[c],memory_order_relaxed);
+}
+
+uint64_t metrics_percentile(const metrics_hist_snapshot_t *s,int pct){
+    uint64_t total=0,seen=0;
+    for(int b=0;b<METRICS_BUCKETS;b++) total+=s->buckets[b];
+    if(!total) return 0;
+    uint64_t want=(total*pct+99)/100;
+    for(int b=0;b<METRICS_BUCKETS;b++){
+        seen+=s->buckets[b];
+        if(seen>=want){
+            uint64_t upper=(uint64_t)2<<b;
+            return upper<s->max_ns ? upper : s->max_ns;
+        }
+    }
+    return s->max_ns;
+}
+
+void metrics_dump(FILE *fp){
+    for(int h=0;h<M_HISTS;h++){
+        metrics_hist_snapshot_t s;
+        metrics_get(h,&s);
+        fprintf(fp,"%-12s n %llu",hist_names[h],(unsigned long long)s.count);
+        if(s.count){
+            fprintf(fp," mean %llu p50 %llu p90 %llu p99 %llu max %llu us",
+                    (unsigned long long)(s.sum_ns/s.count/1000),
+                    (unsigned long long)(metrics_percentile(&s,50)/1000),
+                    (unsigned long long)(metrics_percentile(&s,90)/1000),
+                    (unsigned long long)(metrics_percentile(&s,99)/1000),
+                    (unsigned long long)(s.max_ns/1000));
+        }
+        fputc('\n',fp);
+        // bucket ที่มีค่า: log2(ns):count
+        if(s.count){
+            fprintf(fp,"%-12s","");
+            for(int b=0;b<METRICS_BUCKETS;b++)
+                if(s.buckets[b]) fprintf(fp," %d:%llu",b,(unsigned long long)s.buckets[b]);
+            fputc('\n',fp);
+        }
+    }
+    for(int c=0;c<M_COUNTERS;c++)
+        fprintf(fp,"%-12s %llu\n",counter_names[c],(unsigned long long)metrics_counter(c));
+    fflush(fp);
+}
+
+static void on_signal(int fd,uint32_t events,void *ctx){
+    (void)events; (void)ctx;
+    struct signalfd_siginfo si;
+    while(read(fd,&si,sizeof(si))==sizeof(si)) metrics_dump(stdout);
+}
+
+// ต่อเข้ามาแล้วได้ dump เป็นข้อความหนึ่งชุดแล้วปิด (ไม่ต้องส่งคำสั่ง)
+static void on_accept(int fd,uint32_t events,void *ctx){
+    (void)events; (void)ctx;
+    int c;
+    while((c=accept4(fd,NULL,NULL,SOCK_NONBLOCK|SOCK_CLOEXEC))>=0){
+        char *buf=NULL;
+        size_t len=0;
+        FILE *mem=open_memstream(&buf,&len);
+        if(mem){
+            metrics_dump(mem);
+            fclose(mem);
+            for(size_t off=0;off<len;){
+                ssize_t n=send(c,buf+off,len-off,MSG_NOSIGNAL);   // client ปิดไปก่อน: ไม่โดน SIGPIPE
+                if(n<=0) break;
+                off+=n;
+            }
+            free(buf);
+        }
+        close(c);
+    }
+}
+
+int metrics_start(const char *path){
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set,SIGUSR1);
+    if(pthread_sigmask(SIG_BLOCK,&set,NULL)!=0){ perror("metrics sigmask"); return -1; }
+    sig_fd=signalfd(-1,&set,SFD_NONBLOCK|SFD_CLOEXEC);
+    if(sig_fd<0){ perror("metrics signalfd"); return -1; }
+    if(evloop_add(sig_fd,EPOLLIN,on_signal,NULL)<0) return -1;
+
+    if(!path || !*path) return 0;
+    struct sockaddr_un a;
+    memset(&a,0,sizeof(a));
+    a.sun_family=AF_UNIX;
+    if(strlen(path)>=sizeof(a.sun_path)){ fprintf(stderr,"metrics: socket path too long\n"); return -1; }
+    strcpy(a.sun_path,path);
+
+    listen_fd=socket(AF_UNIX,SOCK_STREAM|SOCK_NONBLOCK|SOCK_CLOEXEC,0);
+    if(listen_fd<0){ perror("metrics socket"); return -1; }
+    unlink(path);
+    if(bind(listen_fd,(struct sockaddr*)&a,sizeof(a))<0 || listen(listen_fd,4)<0){
+        perror("metrics bind");
+        close(listen_fd);
+        listen_fd=-1;
+        return -1;
+    }
+    sock_path=strdup(path);
+    return evloop_add(listen_fd,EPOLLIN,on_accept,NULL);
+}
+
+void metrics_stop(void){
+    if(listen_fd>=0){
+        evloop_del(listen_fd);
+        close(listen_fd);
+        listen_fd=-1;
+        unlink(sock_path);
+        free(sock_path);
+        sock_path=NULL;
+    }
+    if(sig_fd>=0){
+        evloop_del(sig_fd);
+        close(sig_fd);
+        sig_fd=-1;
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+// เวลาของแต่ละขั้นบน hot path (histogram แบบ log2: bucket i = [2^i, 2^(i+1)) ns) และตัวนับ
+// บันทึกด้วย atomic relaxed ไม่มี lock เรียกได้จากทุก thread
+// อ่านได้ตอนทำงานผ่าน SIGUSR1 (พิมพ์ลง stdout) หรือต่อ Unix socket (METRICS_SOCKET ใน .env)
+//   socat - UNIX-CONNECT:/run/monitor_control.sock
+// -DNO_METRICS ตัดทั้งหมดออกตอน compile
+#define METRICS_BUCKETS 32          // bucket สุดท้ายรวมทุกค่าที่ >= 2^31 ns (~2 วินาที)
+
+typedef enum {
+    M_GPIO,             // อ่าน edge/ค่าปุ่มจาก gpiochip
+    M_INPUT,            // debounce + จัดการปุ่ม (input_update)
+    M_RENDER,           // render_text
+    M_FLUSH,            // ส่ง frame ทาง I2C (flush thread)
+    M_SEND,             // sendto/sendmmsg คำสั่ง
+    M_RTT,              // RTT ของ ping monitor
+    M_HISTS
+} metrics_hist_t;
+
+typedef enum {
+    M_PRESSES,
+    M_DATAGRAMS,        // datagram คำสั่งที่ส่ง (รวมส่งซ้ำ)
+    M_PROBES,
+    M_PROBE_LOSS,
+    M_FRAMES,           // frame ที่ส่งถึง OLED
+    M_BUS_BYTES,        // byte บนบัส I2C
+    M_COUNTERS
+} metrics_counter_t;
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+    uint64_t buckets[METRICS_BUCKETS];
+} metrics_hist_snapshot_t;
+
+#ifndef NO_METRICS
+
+static inline uint64_t metrics_now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint64_t)ts.tv_sec*1000000000u+ts.tv_nsec;
+}
+
+void metrics_record(metrics_hist_t h,uint64_t ns);
+void metrics_add(metrics_counter_t c,uint64_t n);
+
+// บันทึกเวลาตั้งแต่ start (ค่าจาก metrics_now())
+static inline void metrics_since(metrics_hist_t h,uint64_t start){ metrics_record(h,metrics_now()-start); }
+
+#else
+
+static inline uint64_t metrics_now(void){ return 0; }
+static inline void metrics_record(metrics_hist_t h,uint64_t ns){ (void)h; (void)ns; }
+static inline void metrics_add(metrics_counter_t c,uint64_t n){ (void)c; (void)n; }
+static inline void metrics_since(metrics_hist_t h,uint64_t start){ (void)h; (void)start; }
+
+#endif
+
+void metrics_get(metrics_hist_t h,metrics_hist_snapshot_t *out);
+uint64_t metrics_counter(metrics_counter_t c);
+
+// ค่าประมาณ percentile (0-100) จากขอบบนของ bucket
+uint64_t metrics_percentile(const metrics_hist_snapshot_t *s,int pct);
+
+void metrics_dump(FILE *fp);
+
+// รับ SIGUSR1 ผ่าน signalfd ใน event loop และเปิด Unix socket ที่ path (NULL = ไม่เปิด)
+// ต้องเรียกก่อนสร้าง thread อื่น (SIGUSR1 ถูก block ให้ทุก thread ที่สร้างตามมา)
+int metrics_start(const char *path);
+void metrics_stop(void);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef MOCK_GPIOD_H
+#define MOCK_GPIOD_H
+
+// libgpiod v1 จำลอง (เฉพาะส่วนที่ monitor_control ใช้) สำหรับ build/รันบนเครื่องที่ไม่มี gpiochip
+// make GPIO=mock ใส่ -Imock และ link mock/gpiod_mock.c แทน -lgpiod
+// ค่าเริ่มต้นของขา: ตัวแปร GPIO_MOCK_INIT="6=1,7=1,8=1,9=1" (ที่ไม่ระบุ = 0)
+// กดปุ่มจาก process อื่น: ตั้ง GPIO_MOCK_CTL=<path> แล้วส่ง datagram "7=0" หรือ "20=1,21=1" ไปที่ Unix socket นั้น
+
+#include <time.h>
+
+#define GPIOD_LINE_BULK_MAX_LINES 64
+
+enum { GPIOD_LINE_EVENT_RISING_EDGE = 1, GPIOD_LINE_EVENT_FALLING_EDGE };
+
+struct gpiod_chip;
+struct gpiod_line;
+
+struct gpiod_line_bulk {
+    struct gpiod_line *lines[GPIOD_LINE_BULK_MAX_LINES];
+    unsigned int num_lines;
+};
+
+struct gpiod_line_event {
+    struct timespec ts;
+    int event_type;
+};
+
+static inline void gpiod_line_bulk_init(struct gpiod_line_bulk *bulk){ bulk->num_lines = 0; }
+static inline void gpiod_line_bulk_add(struct gpiod_line_bulk *bulk, struct gpiod_line *line){
+    bulk->lines[bulk->num_lines++] = line;
+}
+static inline struct gpiod_line *gpiod_line_bulk_get_line(struct gpiod_line_bulk *bulk, unsigned int offset){
+    return bulk->lines[offset];
+}
+
+struct gpiod_chip *gpiod_chip_open_by_name(const char *name);
+void gpiod_chip_close(struct gpiod_chip *chip);
+struct gpiod_line *gpiod_chip_get_line(struct gpiod_chip *chip, unsigned int offset);
+
+int gpiod_line_request_output(struct gpiod_line *line, const char *consumer, int default_val);
+int gpiod_line_set_value(struct gpiod_line *line, int value);
+int gpiod_line_request_bulk_both_edges_events(struct gpiod_line_bulk *bulk, const char *consumer);
+int gpiod_line_get_value_bulk(struct gpiod_line_bulk *bulk, int *values);
+void gpiod_line_release_bulk(struct gpiod_line_bulk *bulk);
+int gpiod_line_event_get_fd(struct gpiod_line *line);
+int gpiod_line_event_read_fd(int fd, struct gpiod_line_event *event);
+
+// ---- ใช้จาก test/benchmark เท่านั้น ----
+// เปลี่ยนค่าขา input (ถ้าขอ event ไว้และค่าเปลี่ยน จะมี edge ให้อ่านจาก fd ของขานั้น)
+void gpiod_mock_set(unsigned int offset, int value);
+// ค่าล่าสุดของขา (output ที่โปรแกรมตั้ง หรือ input ที่ mock ตั้ง)
+int gpiod_mock_get(unsigned int offset);
+
+#endif
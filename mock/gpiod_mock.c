@@ -0,0 +1,178 @@
+#define _GNU_SOURCE
+#include "gpiod.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define MOCK_LINES 64
+
+struct gpiod_line {
+    unsigned int offset;
+    int value;
+    int output;
+    int events[2];          // pipe: [0] ให้โปรแกรมอ่าน, [1] mock เขียน edge
+};
+
+struct gpiod_chip {
+    struct gpiod_line lines[MOCK_LINES];
+};
+
+static struct gpiod_chip chip0;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static int opened;
+static int ctl_fd = -1;
+static pthread_t ctl_thread;
+
+// "6=0,7=0" จาก GPIO_MOCK_CTL: ตั้งทุกขาในข้อความเดียวต่อกัน (กดหลายปุ่ม "พร้อมกัน")
+static void apply(const char *s){
+    while(s && *s){
+        char *end;
+        unsigned long off=strtoul(s,&end,10);
+        if(end==s || *end!='=') return;
+        gpiod_mock_set(off,atoi(end+1));
+        s=strchr(end,',');
+        if(s) s++;
+    }
+}
+
+static void *ctl_main(void *arg){
+    (void)arg;
+    char buf[256];
+    ssize_t n;
+    while((n=recv(ctl_fd,buf,sizeof(buf)-1,0))>=0 || errno==EINTR){
+        if(n<0) continue;
+        buf[n]=0;
+        apply(buf);
+    }
+    return NULL;
+}
+
+// ให้ process อื่น (bench/e2e) กดปุ่มได้: Unix datagram socket ที่ path ใน GPIO_MOCK_CTL
+static void ctl_start(const char *path){
+    struct sockaddr_un a;
+    memset(&a,0,sizeof(a));
+    a.sun_family=AF_UNIX;
+    if(strlen(path)>=sizeof(a.sun_path)){ fprintf(stderr,"gpio mock: socket path too long\n"); return; }
+    strcpy(a.sun_path,path);
+    ctl_fd=socket(AF_UNIX,SOCK_DGRAM|SOCK_CLOEXEC,0);
+    if(ctl_fd<0){ perror("gpio mock socket"); return; }
+    unlink(path);
+    if(bind(ctl_fd,(struct sockaddr*)&a,sizeof(a))<0){
+        perror("gpio mock bind");
+        close(ctl_fd);
+        ctl_fd=-1;
+        return;
+    }
+    if(pthread_create(&ctl_thread,NULL,ctl_main,NULL)!=0){
+        perror("gpio mock thread");
+        return;
+    }
+    pthread_detach(ctl_thread);
+}
+
+struct gpiod_chip *gpiod_chip_open_by_name(const char *name){
+    (void)name;
+    pthread_mutex_lock(&lock);
+    if(!opened){
+        for(unsigned i=0;i<MOCK_LINES;i++){
+            chip0.lines[i].offset=i;
+            chip0.lines[i].events[0]=chip0.lines[i].events[1]=-1;
+        }
+        // "6=1,7=1" -> ค่าเริ่มต้นของขา (ปุ่มแบบ active low ต้องเริ่มที่ 1)
+        // ยังไม่มีใครขอ event จึงไม่มี edge ตอนตั้งค่าเริ่มต้น
+        opened=1;
+        pthread_mutex_unlock(&lock);
+        apply(getenv("GPIO_MOCK_INIT"));
+        const char *ctl=getenv("GPIO_MOCK_CTL");
+        if(ctl && *ctl) ctl_start(ctl);
+        return &chip0;
+    }
+    pthread_mutex_unlock(&lock);
+    return &chip0;
+}
+
+void gpiod_chip_close(struct gpiod_chip *chip){ (void)chip; }
+
+struct gpiod_line *gpiod_chip_get_line(struct gpiod_chip *chip, unsigned int offset){
+    if(offset>=MOCK_LINES){ errno=EINVAL; return NULL; }
+    return &chip->lines[offset];
+}
+
+int gpiod_line_request_output(struct gpiod_line *line, const char *consumer, int default_val){
+    (void)consumer;
+    pthread_mutex_lock(&lock);
+    line->output=1;
+    line->value=default_val!=0;
+    pthread_mutex_unlock(&lock);
+    return 0;
+}
+
+int gpiod_line_set_value(struct gpiod_line *line, int value){
+    pthread_mutex_lock(&lock);
+    line->value=value!=0;
+    pthread_mutex_unlock(&lock);
+    return 0;
+}
+
+int gpiod_line_request_bulk_both_edges_events(struct gpiod_line_bulk *bulk, const char *consumer){
+    (void)consumer;
+    for(unsigned i=0;i<bulk->num_lines;i++){
+        struct gpiod_line *l=bulk->lines[i];
+        if(l->events[0]<0 && pipe2(l->events,O_NONBLOCK|O_CLOEXEC)<0) return -1;
+    }
+    return 0;
+}
+
+int gpiod_line_get_value_bulk(struct gpiod_line_bulk *bulk, int *values){
+    pthread_mutex_lock(&lock);
+    for(unsigned i=0;i<bulk->num_lines;i++) values[i]=bulk->lines[i]->value;
+    pthread_mutex_unlock(&lock);
+    return 0;
+}
+
+void gpiod_line_release_bulk(struct gpiod_line_bulk *bulk){
+    for(unsigned i=0;i<bulk->num_lines;i++){
+        struct gpiod_line *l=bulk->lines[i];
+        if(l->events[0]<0) continue;
+        close(l->events[0]);
+        close(l->events[1]);
+        l->events[0]=l->events[1]=-1;
+    }
+}
+
+int gpiod_line_event_get_fd(struct gpiod_line *line){ return line->events[0]; }
+
+int gpiod_line_event_read_fd(int fd, struct gpiod_line_event *event){
+    return read(fd,event,sizeof(*event))==sizeof(*event) ? 0 : -1;
+}
+
+void gpiod_mock_set(unsigned int offset, int value){
+    if(offset>=MOCK_LINES) return;
+    struct gpiod_line *l=&chip0.lines[offset];
+    value=value!=0;
+    pthread_mutex_lock(&lock);
+    int changed=l->value!=value;
+    l->value=value;
+    int fd=l->events[1];
+    pthread_mutex_unlock(&lock);
+    if(!changed || fd<0) return;
+
+    struct gpiod_line_event ev;
+    clock_gettime(CLOCK_MONOTONIC,&ev.ts);
+    ev.event_type=value ? GPIOD_LINE_EVENT_RISING_EDGE : GPIOD_LINE_EVENT_FALLING_EDGE;
+    if(write(fd,&ev,sizeof(ev))!=sizeof(ev)) perror("gpio mock event");
+}
+
+int gpiod_mock_get(unsigned int offset){
+    if(offset>=MOCK_LINES) return -1;
+    pthread_mutex_lock(&lock);
+    int v=chip0.lines[offset].value;
+    pthread_mutex_unlock(&lock);
+    return v;
+}
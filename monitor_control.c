@@ -11,180 +11,755 @@
 #include <errno.h>
 #include <pthread.h>
 #include <stdint.h>
-#include <ft2build.h>
-#include FT_FREETYPE_H
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
 #include "oled_i2c.h"
-#include "getip.h"
-
-#define DEBOUNCE_DELAY_US 1000
-#define DEBOUNCE_COUNT 1
-#define MAX_MONITORS 3
-#define NUM_KEYS 3
+#include "oled_srv.h"
+#include "font.h"
+#include "scene.h"
+#include "evloop.h"
+#include "health.h"
+#include "status_rx.h"
+#include "proto.h"
+#include "monitors.h"
+#include "discovery.h"
+#include "metrics.h"
+#include "evlog.h"
+#include "config.h"
+#include "netinfo.h"
+
+#define DEBOUNCE_MS 5            // ไม่รับ edge ซ้ำของปุ่มเดิมภายในเวลานี้ (กันสั่น)
+#define NUM_KEYS 3               // ปุ่มเลือกจอ (MON1-3) และ LED R/Y/G มีชุดละ 3 = หนึ่งหน้า
 #define FONT_PATH "./fonts/NotoSerifThai.ttf"
 #define FONT_SIZE 24
-#define PING_TIMEOUT_US 500000  // 0.5s
+#define ACTION_OVERLAY_MS 2000  // ข้อความตอบรับปุ่มแสดงค้างไว้นานเท่านี้
+#define HOLD_MS 3000            // กดค้าง 3 ปุ่ม (ปิดเครื่อง) / UP+DOWN (แสดง IP)
+#define BLINK_MS 500
+#define REPEAT_DELAY_MS 400     // UP/DOWN กดค้างนานเท่านี้เริ่มส่งซ้ำ
+#define REPEAT_START_MS 150     // ช่วงส่งซ้ำแรก แล้วเร็วขึ้นทีละ 1/8
+#define REPEAT_MIN_MS 30
+#define SNAPSHOT_MS 5000        // เลือกจอแล้วนิ่งนานเท่านี้ -> เก็บภาพไว้แสดงตอนเปิดเครื่องครั้งหน้า
+#define CONFIG_ERROR_MS 5000    // .env ที่แก้แล้วผิด แจ้งบน OLED นานเท่านี้
+#define NET_NOTICE_MS 5000      // address/สายของ NET_IFACE เปลี่ยน แจ้งบน OLED นานเท่านี้
+#define BOOT_PHASES 8
 
 // GPIO
 static struct gpiod_chip *chip;
-static struct gpiod_line *do_sw;
-static struct gpiod_line *btn_down;
-static struct gpiod_line *btn_up;
-static struct gpiod_line *btn_done;
-static struct gpiod_line *monitor_keys[NUM_KEYS];
+
+// ปุ่มทั้งหมดขอ event แบบ both edges เป็น bulk เดียว
+// active = ค่าที่ถือว่ากด (ปุ่ม DO และ monitor กด = 0, ปุ่ม UP/DOWN/DONE กด = 1)
+enum { IN_DO, IN_DOWN, IN_UP, IN_DONE, IN_MON1, IN_MON2, IN_MON3, NUM_INPUTS };
+static const struct { unsigned offset; const char *name; int active; } inputs[NUM_INPUTS] = {
+    [IN_DO]   = { 6,  "DO",   0 },
+    [IN_DOWN] = { 21, "DOWN", 1 },
+    [IN_UP]   = { 20, "UP",   1 },  // GPIOA20 / PCM0_DOUT
+    [IN_DONE] = { 17, "DONE", 1 },  // SPDIF-OUT / GPIOA17
+    [IN_MON1] = { 7,  "MON1", 0 },
+    [IN_MON2] = { 8,  "MON2", 0 },
+    [IN_MON3] = { 9,  "MON3", 0 },
+};
+static struct gpiod_line_bulk input_bulk;
+static int input_state[NUM_INPUTS];         // ค่าที่ผ่าน debounce แล้ว
+static int64_t input_settle[NUM_INPUTS];    // ms: ไม่รับ edge ก่อนเวลานี้
 
 // GPIO LED
 static struct gpiod_line *led_red;
 static struct gpiod_line *led_yellow;
 static struct gpiod_line *led_green;
 
-int gpio_lines[NUM_KEYS] = {7,8,9};  // monitor1-3
-const char *key_names[NUM_KEYS] = {"MON1","MON2","MON3"};
+// OLED
+static oled_t *oled;
 
 // Network
 static int sockfd;
-static struct sockaddr_in dest_addr;
-char *monitor_ips[MAX_MONITORS];
-int monitor_port;
+static config_t *config;            // .env ที่ใช้อยู่ แก้ไฟล์แล้วถูกแทนทั้งก้อน (on_config)
 int current_monitor = 0;
-
-int combo_start = 0;
-time_t combo_active = 0;
-
-// FreeType
-FT_Library ft;
-FT_Face face;
-
-// Signal handler
-void intHandler(int dummy){
+static int current_group = -1;  // >= 0: ปุ่มคำสั่งส่งไปทุก monitor ในกลุ่มนี้ (GROUP_<name> ใน .env)
+
+// timer ของ event loop
+static evtimer_t *debounce_timer;   // อ่านค่าปุ่มซ้ำหลังพ้นช่วงกันสั่น
+static evtimer_t *combo_timer;      // UP+DOWN ค้าง -> แสดง IP
+static evtimer_t *shutdown_timer;   // 3 ปุ่ม monitor ค้าง -> ปิดเครื่อง
+static evtimer_t *blink_timer;      // กระพริบ LED (สถานะ monitor / ระหว่างกดค้างปิดเครื่อง)
+static evtimer_t *scene_timer;      // ข้อความชั่วคราวบน OLED หมดเวลา
+static evtimer_t *repeat_timer;     // UP/DOWN กดค้าง -> ส่งซ้ำ
+static evtimer_t *snapshot_timer;   // เก็บภาพหน้าจอสำหรับเปิดเครื่องครั้งถัดไป
+static int repeat_key = -1;
+static int repeat_step;
+static int repeat_ms;
+static int led_blink_state = 0;
+
+// ฟอนต์โหลดใน thread แยกระหว่างเตรียม GPIO/network (ปุ่มใช้ได้ก่อนฟอนต์เสร็จ ข้อความรอวาดใน scene)
+static pthread_t font_thread;
+static int font_fd = -1;            // eventfd: thread โหลดฟอนต์เสร็จ
+static int font_result;
+static int interrupted;     // หยุดเพราะ SIGINT/SIGTERM (ไม่ใช่ 3 ปุ่มปิดเครื่อง)
+static int font_ready;
+static uint64_t font_us;
+
+// เวลาของแต่ละช่วงตอนเริ่มโปรแกรม พิมพ์รวมบรรทัดเดียวเมื่อหน้าจอพร้อม (เทียบ boot time ระหว่าง release)
+static struct { const char *name; uint64_t us; } boot_phase[BOOT_PHASES];
+static int boot_nphases;
+static uint64_t boot_t0, boot_last;
+
+// Ctrl-C/SIGTERM: main เรียกหลัง event loop หยุดแล้ว (ไม่ใช่ใน signal handler จึงรอ lock/join thread ได้)
+static void stop_all(void){
     // ปิด LED ทั้งหมดก่อนออก
     gpiod_line_set_value(led_red, 0);
     gpiod_line_set_value(led_yellow, 0);
     gpiod_line_set_value(led_green, 0);
 
-    gpiod_line_release(do_sw);
-    gpiod_line_release(btn_down);
-    gpiod_line_release(btn_up);
-    gpiod_line_release(btn_done);
-    for(int i=0;i<NUM_KEYS;i++) gpiod_line_release(monitor_keys[i]);
+    gpiod_line_release_bulk(&input_bulk);
     gpiod_chip_close(chip);
     close(sockfd);
-    oled_clear();
-    oled_display();
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
+    config_watch_stop();
+    oled_srv_stop();
+    evlog_stop();
+    status_rx_close();
+    health_stop();
+    proto_stats_t pst;
+    proto_get_stats(&pst);
+    printf("cmd: %u frames, %u coalesced, %u retransmit, %u acked, %u lost\n",
+           pst.frames, pst.coalesced, pst.retransmits, pst.acked, pst.lost);
+    for(int i=0;i<monitors_count();i++){
+        monitor_health_t h;
+        if(health_get(i,&h)<0) continue;
+        printf("monitor%d: %s rtt %u us (min %u) loss %u/1000 sent %u recv %u\n", i+1, h.up?"up":"down",
+               h.srtt_us, h.rtt_min_us, h.loss_permille, h.sent, h.received);
+    }
+    if(oled){
+        oled_clear(oled);
+        oled_display(oled);
+        oled_sync(oled);
+    }
+
+    font_stats_t fst;
+    font_get_stats(&fst);
+    printf("glyph: atlas %u / cache %u hit / %u miss\n", fst.atlas_hits, fst.cache_hits, fst.cache_misses);
+    if(font_result >= 0) font_done();   // main join thread ฟอนต์แล้ว
+    discovery_stop();
+    netinfo_stop();
+    metrics_dump(stdout);
+    metrics_stop();
+    monitors_clear();
     printf("\nExiting safely.\n");
-    exit(0);
 }
 
-// โหลด config จาก env
+// โหลด config จาก env (บรรทัดที่ผิดข้ามไป ตอนเริ่มโปรแกรมไม่มีค่าเดิมให้ย้อนกลับ)
 void load_env_config() {
-    FILE *fp = fopen(".env", "r");
-    if (!fp) {
-        perror("fopen .env");
-        return;
-    }
-
-    char line[256];
-    while (fgets(line, sizeof(line), fp)) {
-        char *key = strtok(line, "=");
-        char *value = strtok(NULL, "\n");
+    config = config_load(".env");
+    if (!config) exit(1);
+    monitors_replace(config->monitors, config->nmonitors, config->groups, config->ngroups);
+}
 
-        if (!key || !value) continue;
+static int64_t now_ms(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (int64_t)ts.tv_sec*1000+ts.tv_nsec/1000000;
+}
 
-        // ตัดช่องว่าง
-        while (*value == ' ') value++;
+static uint64_t now_us(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint64_t)ts.tv_sec*1000000+ts.tv_nsec/1000;
+}
 
-        if (strcmp(key, "MONITOR_IP1") == 0) monitor_ips[0] = strdup(value);
-        else if (strcmp(key, "MONITOR_IP2") == 0) monitor_ips[1] = strdup(value);
-        else if (strcmp(key, "MONITOR_IP3") == 0) monitor_ips[2] = strdup(value);
-        else if (strcmp(key, "MONITOR_PORT") == 0) monitor_port = atoi(value);
+// จบช่วง name ของการเริ่มโปรแกรม (นับจาก boot_mark ครั้งก่อน)
+static void boot_mark(const char *name){
+    uint64_t t = now_us();
+    if(boot_nphases < BOOT_PHASES){
+        boot_phase[boot_nphases].name = name;
+        boot_phase[boot_nphases].us = t - boot_last;
+        boot_nphases++;
     }
-    fclose(fp);
+    boot_last = t;
+}
 
-    // ค่า default ถ้าไม่มีใน .env
-    if (!monitor_ips[0]) monitor_ips[0] = strdup("192.168.1.111");
-    if (!monitor_ips[1]) monitor_ips[1] = strdup("192.168.1.111");
-    if (!monitor_ips[2]) monitor_ips[2] = strdup("192.168.1.130");
-    if (!monitor_port) monitor_port = 5000;
+// จอ/กลุ่มที่เลือกเปลี่ยน: เก็บภาพหลังนิ่งแล้ว (ไม่เขียนทุกครั้งที่กด)
+static void schedule_snapshot(void){
+    if(config->boot_screen[0] && font_ready) evtimer_arm(snapshot_timer, SNAPSHOT_MS, 0);
 }
+
+static void on_snapshot(void *ctx){
+    (void)ctx;
+    int ms = scene_next_expiry_ms();
+    // รอข้อความชั่วคราว ("เลือกจอ" ...) หมดก่อน ให้ภาพที่เก็บเป็นสถานะปกติ
+    if(ms >= 0 || evtimer_armed(shutdown_timer)){ evtimer_arm(snapshot_timer, ms >= 0 ? ms+100 : SNAPSHOT_MS, 0); return; }
+    if(config->boot_screen[0]) oled_save(oled, config->boot_screen);
+}
+
 // ตั้ง monitor ปัจจุบัน
 void set_monitor(int idx) {
-    if(idx < 0 || idx >= MAX_MONITORS) return;
+    const monitor_t *m = monitors_get(idx);
+    if(!m) return;
 
     current_monitor = idx;
-    memset(&dest_addr,0,sizeof(dest_addr));
-    dest_addr.sin_family = AF_INET;
-    dest_addr.sin_port = htons(monitor_port);
-    if(inet_pton(AF_INET, monitor_ips[current_monitor], &dest_addr.sin_addr)<=0){
-        perror("Invalid address");
-        exit(1);
+    evlog_write(EV_SELECT, idx, 0, ntohs(m->addr.sin_port));
+    schedule_snapshot();
+}
+
+// ภาพแรกบนจอก่อนฟอนต์พร้อม: ภาพล่าสุดที่เก็บไว้ หรือรูปจอ 3 จอ (วาดด้วยสี่เหลี่ยม ไม่ต้องใช้ฟอนต์)
+// คืน 1 ถ้าใช้ภาพที่เก็บไว้
+static int show_splash(void){
+    if(config->boot_screen[0] && oled_load(oled, config->boot_screen) == 0){
+        oled_display(oled);
+        return 1;
     }
-    printf("Switched to monitor%d (%s:%d)\n",current_monitor+1,monitor_ips[current_monitor],monitor_port);
+    oled_clear(oled);
+    for(int k=0;k<NUM_KEYS;k++){
+        int x = 8 + k*40;
+        oled_fill_rect(oled, x, 14, 32, 24, 1);
+        oled_fill_rect(oled, x+2, 16, 28, 20, 0);
+        oled_fill_rect(oled, x+14, 38, 4, 6, 1);     // ขาตั้ง
+        oled_fill_rect(oled, x+8, 44, 16, 2, 1);
+    }
+    oled_display(oled);
+    return 0;
 }
 
-// debounce
-int read_line_debounced(struct gpiod_line *line){
-    int last_val = gpiod_line_get_value(line);
-    if(last_val < 0) return last_val;
-    int stable_count = 0;
-    while(stable_count < DEBOUNCE_COUNT){
-        usleep(DEBOUNCE_DELAY_US);
-        int val = gpiod_line_get_value(line);
-        if(val < 0) return val;
-        if(val == last_val) stable_count++;
-        else { stable_count=0; last_val=val; }
+// glyph ที่ใช้บ่อยโหลดไว้ตั้งแต่เริ่ม การกดปุ่มครั้งแรกจะไม่ต้องรอ FreeType
+static void *font_main(void *arg){
+    (void)arg;
+    uint64_t t0 = now_us();
+    font_result = font_init(FONT_PATH);
+    if(font_result == 0){
+        font_preload(FONT_SIZE, "0123456789:/ หน้าจอเชื่อมต่อเลือกจอทำรายการขึ้นลงเสร็จไม่ตอบรับกลุ่มconfigผิด");
+        font_preload(18, "0123456789./:abcdef IPAddressErorNlinkShutdownHold3sกำลังปิดเครื่องเพื่อส่งรับหายconfigใหม่บรรทัดอ่านไฟล์ได้");
     }
-    return last_val;
+    font_us = now_us() - t0;
+    uint64_t one = 1;
+    if(write(font_fd, &one, sizeof(one)) < 0) perror("font eventfd");
+    return NULL;
 }
 
+// ฟอนต์พร้อม: วาดสถานะล่าสุดที่ scene เก็บไว้ (รวมข้อความจากปุ่มที่กดระหว่างรอ) แล้วสรุปเวลาเริ่มโปรแกรม
+static void on_font_ready(int fd, uint32_t events, void *ctx){
+    (void)events; (void)ctx;
+    uint64_t n;
+    if(read(fd, &n, sizeof(n)) < 0) return;
+    pthread_join(font_thread, NULL);
+    evloop_del(fd);
+    close(fd);
+    font_fd = -1;
+    if(font_result < 0){
+        evloop_stop();
+        return;
+    }
+    font_ready = 1;
+    scene_resume();
+
+    struct timespec bt;
+    clock_gettime(CLOCK_BOOTTIME, &bt);
+    char line[256];
+    int len = snprintf(line, sizeof(line), "boot:");
+    for(int i=0;i<boot_nphases;i++){
+        len += snprintf(line+len, sizeof(line)-len, " %s %.1f ms,", boot_phase[i].name, boot_phase[i].us/1000.0);
+        if(len > (int)sizeof(line)-1) len = sizeof(line)-1;    // ตัดแล้ว: line+len ต้องไม่เลยท้าย buffer
+    }
+    printf("%s font %.1f ms (parallel), ready %.1f ms, kernel uptime %.2f s\n", line, font_us/1000.0,
+           (now_us()-boot_t0)/1000.0, bt.tv_sec + bt.tv_nsec/1e9);
+    schedule_snapshot();
+}
+
+// ข้อความที่ไม่เปลี่ยนจะไม่ถูกวาดใหม่ บรรทัดที่เปลี่ยนวาดใหม่เฉพาะพื้นที่ของบรรทัดนั้น
+// ใช้กับข้อความเต็มจอ (IP, ปิดเครื่อง) จึงยกเลิกข้อความชั่วคราวที่ค้างอยู่ด้วย
 void render_monitor_text(const char *line1, const char *line2, int font_size) {
-    // ล้างหน้าจอ
-    oled_clear();
+    scene_set_text(SCENE_HEADER, line1, font_size); // บรรทัดบน
+    scene_set_text(SCENE_STATUS, line2, font_size); // บรรทัดล่าง
+    scene_cancel_overlay(SCENE_HEADER);
+    scene_cancel_overlay(SCENE_STATUS);
+}
 
-    // ตั้งขนาดฟอนต์
-    FT_Set_Pixel_Sizes(face, 0, font_size);
+// สถานะปกติของ monitor (ถ้ามีข้อความชั่วคราวอยู่ จะเห็นหลังหมดเวลา)
+// monitor ที่ส่งข้อความสถานะมา แสดงข้อความนั้นแทน "เชื่อมต่อ"
+// มี monitor มากกว่าปุ่ม: บอกจำนวนทั้งหมดด้วย (เลื่อนหน้าด้วย MON ค้าง + UP/DOWN)
+static void header_text(int idx, char *buf, size_t len){
+    int n = monitors_count();
+    if(n == 0) snprintf(buf,len,"ไม่มีจอ");
+    else if(n > NUM_KEYS) snprintf(buf,len,"หน้าจอ: %d/%d",idx+1,n);
+    else snprintf(buf,len,"หน้าจอ: %d",idx+1);
+}
 
-    // แสดงข้อความ
-    render_text(line1, 0, 30, face); // บรรทัดบน
-    render_text(line2, 0, 60, face); // บรรทัดล่าง
+void show_status(int idx, int connected) {
+    char buf[48];
+    monitor_status_t st;
+    header_text(idx,buf,sizeof(buf));
+    scene_set_text(SCENE_HEADER, buf, FONT_SIZE);
+    if(!connected) scene_set_text(SCENE_STATUS, "", FONT_SIZE);
+    else if(status_rx_get(idx,&st)==0 && st.text[0]) scene_set_text(SCENE_STATUS, st.text, FONT_SIZE);
+    else scene_set_text(SCENE_STATUS, "เชื่อมต่อ", FONT_SIZE);
+}
+
+// ตอบรับการกดปุ่ม: บรรทัดล่างแสดง msg ชั่วคราวแล้วกลับเป็นสถานะเดิมเอง
+void show_action(int idx, const char *msg) {
+    char buf[48];
+    header_text(idx,buf,sizeof(buf));
+    scene_set_text(SCENE_HEADER, buf, FONT_SIZE);
+    scene_overlay(SCENE_STATUS, msg, FONT_SIZE, ACTION_OVERLAY_MS);
+}
+
+// โหมดกลุ่ม: หัวข้อเป็นชื่อกลุ่ม บรรทัดล่างคือจำนวนสมาชิกที่ต่ออยู่
+static void show_group(void){
+    const monitor_group_t *g = monitors_group(current_group);
+    char buf[48];
+    int up = 0;
+    for(int j=0;j<g->n;j++){
+        monitor_health_t h;
+        up += health_get(g->members[j],&h)==0 && h.up;
+    }
+    snprintf(buf,sizeof(buf),"กลุ่ม: %s",g->name);
+    scene_set_text(SCENE_HEADER, buf, FONT_SIZE);
+    snprintf(buf,sizeof(buf),"เชื่อมต่อ %d/%d",up,g->n);
+    scene_set_text(SCENE_STATUS, buf, FONT_SIZE);
+}
+
+// แสดง OLED จากสถานะที่ thread ping เก็บไว้ (ไม่รอ network)
+void display_monitor_status(int idx){
+    monitor_health_t h;
+    if(current_group >= 0){ show_group(); return; }
+    show_status(idx, health_get(idx,&h)==0 && h.up);
+}
+
+// ผลรวมของการส่งแบบกลุ่ม: จำนวนที่ส่งออก แล้วตามด้วย ack/หาย ของ monitor แบบ binary
+static void on_group_update(const proto_group_status_t *st){
+    char buf[48];
+    if(current_group < 0) return;
+    if(st->binary == 0) snprintf(buf,sizeof(buf),"ส่ง %d/%d",st->sent,st->targets);
+    else if(st->lost) snprintf(buf,sizeof(buf),"รับ %d/%d หาย %d",st->acked+st->targets-st->binary,st->targets,st->lost);
+    else snprintf(buf,sizeof(buf),"รับ %d/%d",st->acked+st->targets-st->binary,st->targets);
+    scene_overlay(SCENE_STATUS, buf, 18, ACTION_OVERLAY_MS);
+}
+
+// คำสั่งส่งซ้ำครบแล้วไม่มี ack (เฉพาะ monitor แบบ binary)
+static void on_cmd_lost(int idx, int cmd){
+    evlog_write(EV_LOST, idx, cmd, 0);
+    if(idx==current_monitor && current_group < 0) show_action(idx,"ไม่ตอบรับ");
+}
+
+static void set_leds(int r,int y,int g){
+    gpiod_line_set_value(led_red,   r);
+    gpiod_line_set_value(led_yellow,y);
+    gpiod_line_set_value(led_green, g);
+}
+
+// monitor ที่ปุ่ม MON1-3 / LED R,Y,G ชี้อยู่คือหน้าที่มี monitor ที่เลือก
+static int page_base(void){ return current_monitor - current_monitor%NUM_KEYS; }
+
+// monitor ที่ปุ่มคำสั่งจะส่งไป
+static int is_target(int i){
+    const monitor_group_t *g = monitors_group(current_group);
+    if(!g) return i==current_monitor;
+    for(int j=0;j<g->n;j++) if(g->members[j]==i) return 1;
+    return 0;
+}
+
+// LED ของ monitor ในหน้าปัจจุบัน (R/Y/G = ช่อง 1-3 ของหน้า): ติด = จอที่เลือก
+// กระพริบ = monitor ที่ต่ออยู่ส่งสถานะ code > 0
+// ระหว่างกดค้างปิดเครื่อง on_blink คุม LED เอง
+static void update_leds(void){
+    int on[NUM_KEYS], attn=0;
+    if(evtimer_armed(shutdown_timer)) return;
+    for(int k=0;k<NUM_KEYS;k++){
+        int i = page_base()+k;
+        monitor_status_t st;
+        monitor_health_t h;
+        int a = status_rx_get(i,&st)==0 && st.code>0 && health_get(i,&h)==0 && h.up;
+        on[k] = a ? led_blink_state : is_target(i);
+        attn |= a;
+    }
+    set_leds(on[0], on[1], on[2]);
+    if(attn && !evtimer_armed(blink_timer)) evtimer_arm(blink_timer, BLINK_MS, BLINK_MS);
+    else if(!attn && evtimer_armed(blink_timer)) evtimer_disarm(blink_timer);
+}
+
+static int pressed(int in){ return input_state[in]==inputs[in].active; }
+
+static const int key_cmd[NUM_INPUTS] = { [IN_DO]=PROTO_DO, [IN_DOWN]=PROTO_DOWN, [IN_UP]=PROTO_UP, [IN_DONE]=PROTO_DONE };
+
+// ส่งคำสั่งไปจอที่เลือก หรือทุกจอในกลุ่ม (sendmmsg ครั้งเดียว ไม่ต้องเลือกทีละจอ)
+static void send_cmd(int cmd, int count){
+    const monitor_group_t *g = monitors_group(current_group);
+    if(g) evlog_write(EV_SEND, -1, cmd, proto_send_group(g->members, g->n, cmd, count, on_group_update));
+    else {
+        proto_send(current_monitor, cmd, count);
+        evlog_write(EV_SEND, current_monitor, cmd, count);
+    }
+}
+
+// MON ค้าง + DONE: วนเลือกกลุ่ม ไม่มีกลุ่ม -> กลุ่มแรก -> ... -> กลุ่มสุดท้าย -> ไม่มีกลุ่ม
+static void cycle_group(void){
+    int n = monitors_group_count();
+    if(n == 0) return;
+    current_group = current_group+1 < n ? current_group+1 : -1;
+    evlog_write(EV_GROUP, -1, current_group+1, current_group >= 0 ? monitors_group(current_group)->n : 0);
+    display_monitor_status(current_monitor);
+    schedule_snapshot();
+    update_leds();
+}
+
+static void select_monitor(int i){
+    if(!monitors_get(i)){
+        evlog_write(EV_SELECT, i, 0, -1);
+        return;
+    }
+    current_group = -1;     // เลือกจอเดียว = ออกจากโหมดกลุ่ม
+    set_monitor(i);
+    display_monitor_status(i);
+
+    // ส่งข้อความ UDP ไป monitor ที่เลือก
+    proto_send(i, PROTO_SELECT, i+1);
 
     // แสดงผลบน OLED
-    oled_display();
+    show_action(i,"เลือกจอ");
+
+    // ✅ ควบคุม LED ตาม monitor
+    update_leds();
 }
 
-// ตรวจสอบ monitor ด้วย ping/pong
-int check_monitor(){
-    struct sockaddr_in addr = dest_addr;
-    char buf[16];
-    fd_set readfds;
-    struct timeval tv;
-    int ret;
+// MON ค้าง + UP/DOWN: เลื่อนหน้าละ NUM_KEYS จอ (วนรอบ) แล้วเลือกจอช่องของปุ่มที่ค้างอยู่
+static void page_monitors(int key, int dir){
+    int n = monitors_count();
+    int pages = (n + NUM_KEYS - 1) / NUM_KEYS;
+    if(pages <= 1) return;
+    int page = (current_monitor/NUM_KEYS + dir + pages) % pages;
+    int i = page*NUM_KEYS + key;
+    if(i >= n) i = n-1;
+    evlog_write(EV_PAGE, i, key, page+1);
+    select_monitor(i);
+}
 
-    const char *msg = "ping";
-    sendto(sockfd,msg,strlen(msg),0,(struct sockaddr*)&addr,sizeof(addr));
+// UP+DOWN ค้างครบเวลา -> แสดง IP (ครั้งเดียวต่อการกดค้าง)
+// address มาจากตารางของ netinfo.c (อัปเดตตาม event ของ kernel) ไม่มี syscall บนเส้นทางปุ่ม
+static void on_combo(void *ctx){
+    (void)ctx;
+    char ip[INET6_ADDRSTRLEN];
+    if (netinfo_link_up(config->net_iface) == 0) {
+        evlog_write(EV_COMBO, -1, 0, -1);
+        render_monitor_text("IP Address", "No link", 18);
+    } else if (netinfo_addr(config->net_iface, ip, sizeof(ip)) >= 0) {
+        evlog_write(EV_COMBO, -1, 0, 0);
+        render_monitor_text("IP Address", ip, 18);
+    } else {
+        evlog_write(EV_COMBO, -1, 0, -1);
+        render_monitor_text("IP Address", "Error", 18);
+    }
+}
 
-    FD_ZERO(&readfds);
-    FD_SET(sockfd,&readfds);
-    tv.tv_sec = 0;
-    tv.tv_usec = PING_TIMEOUT_US;
+// ตาราง address เปลี่ยน: address หลักหรือสายของ NET_IFACE ต่างจากครั้งก่อน (DHCP ได้ address ใหม่, สายหลุด/ต่อ)
+// แจ้งบน OLED ทันทีแล้วถามหา monitor ใหม่ (อาจย้ายไปอยู่วงอื่น) ครั้งแรก/เปลี่ยน NET_IFACE จำไว้เฉยๆ
+static void on_netinfo(void){
+    static char last_iface[CONFIG_STR_MAX], last_ip[INET6_ADDRSTRLEN];
+    static int last_up;
+    char ip[INET6_ADDRSTRLEN] = "";
+    int up = netinfo_link_up(config->net_iface) > 0;
+    int family = netinfo_addr(config->net_iface, ip, sizeof(ip));
+    if(family < 0) ip[0] = 0;
+
+    int known = strcmp(last_iface, config->net_iface) == 0;
+    int changed = up != last_up || strcmp(ip, last_ip) != 0;
+    snprintf(last_iface, sizeof(last_iface), "%s", config->net_iface);
+    snprintf(last_ip, sizeof(last_ip), "%s", ip);
+    last_up = up;
+    if(!known || !changed) return;
+
+    evlog_write(EV_NET, -1, up, family);
+    scene_overlay(SCENE_HEADER, "IP Address", 18, NET_NOTICE_MS);
+    scene_overlay(SCENE_STATUS, !up ? "No link" : ip[0] ? ip : "No address", 18, NET_NOTICE_MS);
+    if(up && ip[0]) discovery_query();
+}
+
+// UP/DOWN กดค้าง: ส่งซ้ำถี่ขึ้นเรื่อยๆ จนถึง REPEAT_MIN_MS แล้วเพิ่มจำนวนต่อครั้งแทน
+// ครั้งที่ถี่กว่าหน้าต่างของ proto จะถูกรวมเป็น datagram เดียวที่มี count
+static void on_repeat(void *ctx){
+    (void)ctx;
+    if(repeat_key<0 || !pressed(repeat_key)){ repeat_key = -1; return; }
+    int count = 1 + repeat_step/16;
+    if(count > 4) count = 4;
+    send_cmd(key_cmd[repeat_key], count);
+    repeat_step++;
+    repeat_ms -= repeat_ms/8;
+    if(repeat_ms < REPEAT_MIN_MS) repeat_ms = REPEAT_MIN_MS;
+    evtimer_arm(repeat_timer, repeat_ms, 0);
+}
+
+static void on_blink(void *ctx){
+    (void)ctx;
+    led_blink_state = !led_blink_state;
+    if(evtimer_armed(shutdown_timer)) set_leds(led_blink_state, led_blink_state, led_blink_state);
+    else update_leds();
+}
 
-    ret = select(sockfd+1,&readfds,NULL,NULL,&tv);
-    if(ret > 0 && FD_ISSET(sockfd,&readfds)){
-        socklen_t len = sizeof(addr);
-        int n = recvfrom(sockfd,buf,sizeof(buf)-1,0,(struct sockaddr*)&addr,&len);
-        if(n>0){ buf[n]=0; if(strcmp(buf,"pong")==0) return 1; }
+// 3 ปุ่ม monitor ค้างครบเวลา -> Shutdown
+static void on_shutdown(void *ctx){
+    (void)ctx;
+    evlog_write(EV_SHUTDOWN, -1, 0, 0);
+    evlog_stop();
+    render_monitor_text("Shutdown","กำลังปิดเครื่อง", 18);
+    oled_sync(oled);
+    if(system(config->shutdown_cmd) != 0) fprintf(stderr,"%s: failed\n", config->shutdown_cmd);
+    evloop_stop();
+}
+
+// monitor ตัวใดตัวหนึ่งเปลี่ยน up/down
+static void on_health(int fd, uint32_t events, void *ctx){
+    (void)events; (void)ctx;
+    static int first = 1;
+    uint64_t n;
+    if(read(fd, &n, sizeof(n)) < 0) return;
+    if(first){
+        first = 0;
+        printf("boot: first monitor status %.1f ms\n", (now_us()-boot_t0)/1000.0);
     }
-    return 0;
+    // บันทึกเฉพาะตัวที่ up/down เปลี่ยนจากครั้งก่อน (result = 1 up, 0 down)
+    static uint8_t was_up[MONITOR_MAX];
+    for(int i=0;i<monitors_count();i++){
+        monitor_health_t h;
+        if(health_get(i,&h)<0 || h.up==was_up[i]) continue;
+        was_up[i] = h.up;
+        evlog_write(EV_HEALTH, i, 0, h.up);
+    }
+    display_monitor_status(current_monitor);
+    update_leds();
 }
 
-// แสดง OLED + เช็ค connection
-void display_monitor_status(int idx){
-    char buf[32];
-    snprintf(buf,sizeof(buf),"หน้าจอ: %d",idx+1);
-    int connected = check_monitor();
-    char buf2[32];
-    snprintf(buf2,sizeof(buf2),connected?"เชื่อมต่อ":"            ");
-    render_monitor_text(buf,buf2,FONT_SIZE);
+// monitor ส่งสถานะใหม่มา
+static void on_status(int idx){
+    monitor_status_t st;
+    if(status_rx_get(idx,&st)==0) evlog_write(EV_STATUS, idx, 0, st.code);
+    if(idx==current_monitor) display_monitor_status(idx);
+    update_leds();
+}
+
+static void on_scene_timer(void *ctx){
+    (void)ctx;
+    scene_tick();
+}
+
+// ก่อนรอ event รอบถัดไป: ตั้ง timer ให้ตรงกับ overlay ที่จะหมดเวลาหรือ marquee ที่จะเลื่อนถัดไป
+static void before_wait(void){
+    int ms=scene_next_expiry_ms(), step=scene_next_step_ms();
+    if(step>=0 && (ms<0 || step<ms)) ms=step;
+    if(ms>=0) evtimer_arm(scene_timer, ms>0 ? ms : 1, 0);     // ms 0 = ปิด timer
+    else if(evtimer_armed(scene_timer)) evtimer_disarm(scene_timer);
+}
+
+// ปุ่มเปลี่ยนสถานะ (ผ่าน debounce แล้ว)
+static void on_input(int in, int val){
+    int down = val==inputs[in].active;
+
+    switch(in){
+    case IN_DO:
+    case IN_DOWN:
+    case IN_UP:
+    case IN_DONE:
+        if(in!=IN_DO && !evtimer_armed(shutdown_timer)){
+            int held = pressed(IN_MON1) ? 0 : pressed(IN_MON2) ? 1 : pressed(IN_MON3) ? 2 : -1;
+            if(held >= 0){
+                if(down && in==IN_DONE) cycle_group();
+                else if(down) page_monitors(held, in==IN_UP ? 1 : -1);
+                break;
+            }
+        }
+        if(down){
+            static const char *text[] = { [IN_DO]="ทำรายการ", [IN_DOWN]="ลง", [IN_UP]="ขึ้น", [IN_DONE]="เสร็จ" };
+            send_cmd(key_cmd[in], 1);
+            // โหมดกลุ่ม OLED แสดงผลรวมจาก on_group_update
+            if(current_group < 0) show_action(current_monitor,text[in]);
+        }
+        // ตรวจว่ากด UP+DOWN พร้อมกันหรือไม่
+        if(in==IN_DOWN || in==IN_UP){
+            if(pressed(IN_DOWN) && pressed(IN_UP)){
+                if(!evtimer_armed(combo_timer)) evtimer_arm(combo_timer, HOLD_MS, 0);
+                evtimer_disarm(repeat_timer);   // กดพร้อมกัน = คำสั่งแสดง IP ไม่ใช่เลื่อน
+                repeat_key = -1;
+            } else {
+                evtimer_disarm(combo_timer);
+                if(down){
+                    repeat_key = in;
+                    repeat_step = 0;
+                    repeat_ms = REPEAT_START_MS;
+                    evtimer_arm(repeat_timer, REPEAT_DELAY_MS, 0);
+                } else if(in==repeat_key){
+                    evtimer_disarm(repeat_timer);
+                    repeat_key = -1;
+                }
+            }
+        }
+        break;
+
+    default: {
+        int i = page_base()+in-IN_MON1;
+        if(down) select_monitor(i);
+
+        if(pressed(IN_MON1) && pressed(IN_MON2) && pressed(IN_MON3)){
+            // กดครบ 3 ปุ่ม: เริ่มจับเวลา + กระพริบ LED ทุก 0.5 วินาที
+            render_monitor_text("Hold 3s","เพื่อปิดเครื่อง", 18);  // แสดงบน OLED
+            evtimer_arm(shutdown_timer, HOLD_MS, 0);
+            evtimer_arm(blink_timer, BLINK_MS, BLINK_MS);
+        } else if(evtimer_armed(shutdown_timer)){
+            // reset ถ้ามีปุ่มปล่อย
+            evtimer_disarm(shutdown_timer);
+            evtimer_disarm(blink_timer);   // ปิด LED กระพริบ -> กลับปกติ (update_leds ข้างล่าง)
+
+            // ล้างข้อความ OLED
+            render_monitor_text("","", FONT_SIZE);
+
+            // ✅ ตั้ง monitor1 เป็นค่าเริ่มต้น
+            current_group = -1;
+            set_monitor(0);
+            display_monitor_status(0);
+
+            // ปรับ LED ตาม monitor1
+            update_leds();
+
+            // แสดงบน OLED ว่าเลือก monitor1
+            show_action(0,"เลือกจอ");
+        }
+        break;
+    }
+    }
+}
+
+// รับค่าใหม่ของปุ่ม: เปลี่ยนทันทีที่เห็น edge แรก (ไม่เพิ่ม latency)
+// แล้วไม่สน edge ของปุ่มนั้นจนพ้น DEBOUNCE_MS จากนั้นอ่านค่าซ้ำเผื่อสั่นจบที่ค่าอื่น
+static void input_update(int in, int val, int64_t now){
+    uint64_t t0 = metrics_now();
+    if(now < input_settle[in]){
+        evtimer_arm(debounce_timer, (int)(input_settle[in]-now), 0);
+        return;
+    }
+    if(val == input_state[in]) return;
+    input_state[in] = val;
+    input_settle[in] = now + DEBOUNCE_MS;
+    evtimer_arm(debounce_timer, DEBOUNCE_MS, 0);
+    if(val == inputs[in].active) metrics_add(M_PRESSES, 1);
+    evlog_write(val == inputs[in].active ? EV_PRESS : EV_RELEASE, -1, in, 0);
+    on_input(in, val);
+    metrics_since(M_INPUT, t0);
+}
+
+static void on_gpio_event(int fd, uint32_t events, void *ctx){
+    (void)events;
+    int in = (int)(intptr_t)ctx;
+    struct gpiod_line_event ev;
+    uint64_t t0 = metrics_now();
+    if(gpiod_line_event_read_fd(fd, &ev) < 0) return;
+    metrics_since(M_GPIO, t0);
+    input_update(in, ev.event_type==GPIOD_LINE_EVENT_RISING_EDGE, now_ms());
+}
+
+static void on_debounce(void *ctx){
+    (void)ctx;
+    int vals[NUM_INPUTS];
+    uint64_t t0 = metrics_now();
+    if(gpiod_line_get_value_bulk(&input_bulk, vals) < 0) return;
+    metrics_since(M_GPIO, t0);
+    int64_t now = now_ms();
+    for(int i=0;i<NUM_INPUTS;i++) input_update(i, vals[i], now);
+}
+
+// monitor ตอบ/ประกาศตัวผ่าน discovery: ตัวใหม่ต่อท้ายตาราง แล้วเริ่ม ping/รับสถานะ/ส่งคำสั่งได้ทันที
+static void on_discovered(const struct sockaddr_in *addr, int proto, const char *name){
+    if(monitors_find(addr) >= 0) return;
+    int i = monitors_add(addr, proto, name, 1);
+    if(i < 0) return;
+    if(health_add(addr) != i || proto_add(addr, proto) != i || status_rx_add(addr) != i){
+        fprintf(stderr,"monitor%d: registry out of sync\n", i+1);
+        return;
+    }
+    const monitor_t *m = monitors_get(i);
+    evlog_write(EV_FOUND, i, proto, ntohs(m->addr.sin_port));
+    display_monitor_status(current_monitor);   // จำนวนจอบนหัวข้อเปลี่ยน
+    update_leds();
+}
+
+// .env ใหม่ (แปลง address แล้ว): ตาราง monitor สร้างใหม่ทั้งตารางแล้วสลับครั้งเดียว
+// monitor จาก discovery ที่ไม่ซ้ำกับ .env ยังต่อท้ายเหมือนเดิม คืนจำนวนช่องที่เปลี่ยน หรือ -1
+static int apply_monitors(const config_t *c){
+    monitor_t t[MONITOR_MAX];
+    int n = c->nmonitors, changed = 0;
+    memcpy(t, c->monitors, n*sizeof(*t));
+    for(int i=0;i<monitors_count() && n<MONITOR_MAX;i++){
+        const monitor_t *m = monitors_get(i);
+        int dup = 0;
+        for(int j=0;j<c->nmonitors;j++)
+            dup |= t[j].addr.sin_addr.s_addr==m->addr.sin_addr.s_addr && t[j].addr.sin_port==m->addr.sin_port;
+        if(m->discovered && !dup) t[n++] = *m;
+    }
+
+    struct sockaddr_in addrs[MONITOR_MAX];
+    int modes[MONITOR_MAX];
+    for(int i=0;i<n;i++){
+        const monitor_t *m = monitors_get(i);
+        changed += !m || memcmp(&m->addr, &t[i].addr, sizeof(m->addr)) != 0 || m->proto != t[i].proto;
+        addrs[i] = t[i].addr;
+        modes[i] = t[i].proto;
+    }
+    if(monitors_count() > n) changed += monitors_count() - n;
+
+    if(monitors_replace(t, n, c->groups, c->ngroups) < 0) return -1;
+    // ช่องที่ address เดิมไม่ถูกแตะ: seq, สถิติ ping, สถานะ และคำสั่งที่รอ ack อยู่ไปต่อได้
+    if(proto_update(addrs, modes, n) < 0 || health_update(addrs, n) < 0 || status_rx_update(addrs, n) < 0)
+        fprintf(stderr,"config: registry out of sync\n");
+    return changed;
+}
+
+// thread ของ config อ่าน .env ที่แก้แล้ว: ผิด = ใช้ค่าเดิมต่อแล้วแจ้งบน OLED, ถูก = สลับทันทีไม่ต้อง restart
+// จอที่เลือกอยู่ไม่เปลี่ยน (ยกเว้นถูกลบออกไป) ปุ่มที่กดค้างอยู่ส่งต่อไปที่ address ใหม่
+static void on_config(int fd, uint32_t events, void *ctx){
+    (void)fd; (void)events; (void)ctx;
+    config_t *c = config_take();
+    char buf[128];
+    if(!c) return;
+
+    if(c->error[0]){
+        evlog_write(EV_CONFIG, -1, 1, c->error_line);
+        if(c->error_line > 0) snprintf(buf,sizeof(buf),"บรรทัด %d",c->error_line);
+        else snprintf(buf,sizeof(buf),"อ่านไฟล์ไม่ได้");
+        scene_overlay(SCENE_HEADER, "config ผิด", FONT_SIZE, CONFIG_ERROR_MS);
+        scene_overlay(SCENE_STATUS, buf, 18, CONFIG_ERROR_MS);
+        free(c);
+        return;
+    }
+
+    if(config_restart_keys(config, c, buf, sizeof(buf)) > 0) fprintf(stderr,"config: %s changed, restart to apply\n", buf);
+    int changed = apply_monitors(c);
+    if(changed < 0){ free(c); return; }
+    free(config);
+    config = c;     // SHUTDOWN_CMD, BOOT_SCREEN ใช้ค่าใหม่ตั้งแต่ตอนนี้
+    evlog_write(EV_CONFIG, -1, 0, monitors_count());
+
+    if(current_group >= monitors_group_count()) current_group = -1;
+    if(current_monitor >= monitors_count()){
+        current_monitor = 0;
+        set_monitor(0);
+    }
+    display_monitor_status(current_monitor);
+    update_leds();
+    scene_overlay(SCENE_STATUS, "config ใหม่", 18, ACTION_OVERLAY_MS);
+}
+
+// socket ส่งคำสั่ง: ที่เข้ามามีแค่ ack ของ monitor แบบ binary (ping ใช้ socket ของ health)
+static void on_udp(int fd, uint32_t events, void *ctx){
+    (void)events; (void)ctx;
+    uint8_t buf[64];
+    struct sockaddr_in from;
+    socklen_t len = sizeof(from);
+    ssize_t n;
+    while((n = recvfrom(fd, buf, sizeof(buf), MSG_DONTWAIT, (struct sockaddr*)&from, &len)) > 0){
+        proto_input(buf, n, &from);
+        len = sizeof(from);
+    }
+}
+
+// SIGINT/SIGTERM มาทาง signalfd: แค่หยุด loop ที่เหลือ main ปิดเอง
+static void on_stop_signal(int fd, uint32_t events, void *ctx){
+    (void)events; (void)ctx;
+    struct signalfd_siginfo si;
+    while(read(fd, &si, sizeof(si)) == sizeof(si))
+        ;
+    interrupted = 1;
+    evloop_stop();
 }
 
 int main(){
@@ -193,11 +768,39 @@ int main(){
 
     printf("monitor_control starting...\n");
     fflush(stdout);
+    boot_t0 = boot_last = now_us();
 
-    signal(SIGINT,intHandler);
     load_env_config();
-
-    chip = gpiod_chip_open_by_name("gpiochip0");
+    boot_mark("env");
+
+    if(evloop_init() < 0) return 1;
+    // ก่อนสร้าง thread ใดๆ: SIGINT/SIGTERM ถูก block ทุก thread (ไม่ไปตกที่ thread ส่ง OLED/ping)
+    // แล้วรับผ่าน signalfd ใน loop นี้
+    sigset_t stop_set;
+    sigemptyset(&stop_set);
+    sigaddset(&stop_set, SIGINT);
+    sigaddset(&stop_set, SIGTERM);
+    if(pthread_sigmask(SIG_BLOCK, &stop_set, NULL) != 0){ perror("sigmask"); return 1; }
+    int stop_fd = signalfd(-1, &stop_set, SFD_NONBLOCK|SFD_CLOEXEC);
+    if(stop_fd < 0){ perror("signalfd"); return 1; }
+    if(evloop_add(stop_fd, EPOLLIN, on_stop_signal, NULL) < 0) return 1;
+    // ก่อนสร้าง thread ใดๆ: SIGUSR1 ต้องถูก block ทุก thread แล้วรับผ่าน signalfd ใน loop นี้
+    if(metrics_start(config->metrics_socket) < 0) fprintf(stderr,"metrics socket disabled\n");
+
+    // จอมีภาพก่อนอย่างอื่น: init SSD1306 + ภาพแรกส่งจาก flush thread ขนานกับงานข้างล่าง
+    if(!(oled = oled_open(OLED_BUS, OLED_ADDR, 128, 64))) return 1;
+    boot_mark(show_splash() ? "splash(last)" : "splash");
+
+    // ฟอนต์ (เปิด TTF + glyph ที่ใช้บ่อย) ช้าที่สุด ทำใน thread แยกไปพร้อมกับ GPIO/network
+    font_fd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+    if(font_fd < 0){ perror("font eventfd"); return 1; }
+    if(evloop_add(font_fd, EPOLLIN, on_font_ready, NULL) < 0) return 1;
+    if(pthread_create(&font_thread, NULL, font_main, NULL) != 0){ perror("font thread"); return 1; }
+
+    // ปุ่มไม่ printf เอง: เขียน record ลง ring แล้ว thread ของ evlog เขียนออกไป
+    if(evlog_start(config->event_log[0] ? config->event_log : NULL, config->event_log_format) < 0) return 1;
+
+    chip = gpiod_chip_open_by_name(config->gpio_chip);
     if(!chip){ perror("Open chip failed"); return 1; }
 
 
@@ -223,247 +826,91 @@ int main(){
         return 1;
     }
 
-    // ปุ่ม DO
-    do_sw = gpiod_chip_get_line(chip,6);
-    if(!do_sw){ perror("Get line failed"); return 1; }
-    if(gpiod_line_request_input(do_sw,"sw_do")<0){ perror("Request input failed"); return 1; }
-
-    // ปุ่ม DOWN
-    btn_down = gpiod_chip_get_line(chip,21);
-    if(!btn_down){ perror("Get line failed"); return 1; }
-    if(gpiod_line_request_input(btn_down,"sw_down")<0){ perror("Request input failed"); return 1; }
-
-    // ปุ่ม UP (GPIOA20 / PCM0_DOUT)
-    btn_up = gpiod_chip_get_line(chip,20);
-    if(!btn_up){ perror("Get line failed"); return 1; }
-    if(gpiod_line_request_input(btn_up,"sw_up")<0){ perror("Request input failed"); return 1; }
-
-    // ปุ่ม DONE (SPDIF-OUT / GPIOA17)
-    btn_done = gpiod_chip_get_line(chip,17);
-    if(!btn_done){ perror("Get line failed"); return 1; }
-    if(gpiod_line_request_input(btn_done,"sw_done")<0){ perror("Request input failed"); return 1; }
-
-    // ปุ่ม monitor
-    for(int i=0;i<NUM_KEYS;i++){
-        monitor_keys[i]=gpiod_chip_get_line(chip,gpio_lines[i]);
-        if(!monitor_keys[i]){ perror("Get line failed"); return 1; }
-        if(gpiod_line_request_input(monitor_keys[i],"monitor_keys")<0){ perror("Request input failed"); return 1; }
+    // ปุ่มทั้งหมด: ขอ edge event ทั้งขาขึ้น/ลงเป็น bulk เดียว
+    // (libgpiod v1 ไม่มี debounce ใน kernel จึงกันสั่นเองด้วย timer)
+    gpiod_line_bulk_init(&input_bulk);
+    for(int i=0;i<NUM_INPUTS;i++){
+        struct gpiod_line *line = gpiod_chip_get_line(chip, inputs[i].offset);
+        if(!line){ perror("Get line failed"); return 1; }
+        gpiod_line_bulk_add(&input_bulk, line);
+    }
+    if(gpiod_line_request_bulk_both_edges_events(&input_bulk, "monitor_control") < 0){
+        perror("Request events failed");
+        return 1;
+    }
+    if(gpiod_line_get_value_bulk(&input_bulk, input_state) < 0){
+        perror("Read input failed");
+        return 1;
     }
+    for(int i=0;i<NUM_INPUTS;i++){
+        int fd = gpiod_line_event_get_fd(gpiod_line_bulk_get_line(&input_bulk, i));
+        if(fd < 0 || evloop_add(fd, EPOLLIN, on_gpio_event, (void*)(intptr_t)i) < 0) return 1;
+    }
+    boot_mark("gpio");
 
     // socket UDP
     sockfd=socket(AF_INET,SOCK_DGRAM,0);
     if(sockfd<0){ perror("Socket failed"); return 1; }
+    evloop_add(sockfd, EPOLLIN, on_udp, NULL);
 
     set_monitor(current_monitor);
 
-    // OLED + FreeType
-    oled_init();
-    if (FT_Init_FreeType(&ft)) { fprintf(stderr,"Could not init FreeType\n"); return 1; }
-    if (FT_New_Face(ft,FONT_PATH,0,&face)) { fprintf(stderr,"Failed to load font\n"); return 1; }
-    FT_Set_Pixel_Sizes(face,0,FONT_SIZE);
-
-    display_monitor_status(current_monitor); // แสดง monitor เริ่มต้น + check
-
-    int last_do_state=1;
-    int last_down_state=1;
-    int last_up_state=1;
-    int last_done_state=1;
-    int last_monitor_state[NUM_KEYS]={1,1,1};
-
-    time_t last_check = 0;
-
-    time_t shutdown_start = 0;  // เก็บเวลาที่เริ่มกด 3 ปุ่ม
-    int led_blink_state = 0;    // สำหรับกระพริบ LED
-    time_t last_blink = 0;      // เก็บเวลาล่าสุดที่สลับไฟ
-
-    gpiod_line_set_value(led_red, 1);
-
-    while(1){
-        // ปุ่ม DO
-        int val_do=read_line_debounced(do_sw);
-        if(val_do==0 && last_do_state!=0){
-            printf("DO pressed! Sending 'do' to monitor %d\n",current_monitor+1);
-            const char *msg="do";
-            if(sendto(sockfd,msg,strlen(msg),0,(struct sockaddr*)&dest_addr,sizeof(dest_addr))<0)
-                perror("Send failed");
-
-            char buf[32]; snprintf(buf,sizeof(buf),"หน้าจอ: %d",current_monitor+1);
-            render_monitor_text(buf,"ทำรายการ", FONT_SIZE);
-        }
-        last_do_state=val_do;
-
-        int val_down = read_line_debounced(btn_down);  // 0 = pressed
-        int val_up   = read_line_debounced(btn_up);    // 0 = pressed
-
-        // ตรวจว่ากดพร้อมกันหรือไม่
-        if (val_down == 1 && val_up == 1) {
-            if (!combo_active) {
-                // เพิ่งกดพร้อมกันครั้งแรก
-                combo_start = time(NULL);
-                combo_active = 1;
-            } else {
-                // กำลังกดค้าง
-                if (time(NULL) - combo_start >= 3) {
-                    char ip[64];
-                    if (get_ip_address("eth0", ip, sizeof(ip)) == 0) {
-                        printf("📡 IP Address: %s\n", ip);
-                        render_monitor_text("IP Address", ip, 18);
-                    } else {
-                        render_monitor_text("IP Address", "Error", 18);
-                    }
-                    combo_active = 0;   // reset ไม่ให้โชว์ซ้ำ
-                }
-            }
-        } else {
-            // ปล่อยปุ่ม
-            combo_active = 0;
-            combo_start = 0;
-        }
-
-        // ====== โค้ดปุ่ม DOWN ปกติ ======
-        if (val_down==1 && last_down_state!=1){
-            printf("DOWN pressed! Sending 'down' to monitor %d\n",current_monitor+1);
-            const char *msg="down";
-            if(sendto(sockfd,msg,strlen(msg),0,(struct sockaddr*)&dest_addr,sizeof(dest_addr))<0)
-                perror("Send failed");
-
-            char buf[32]; snprintf(buf,sizeof(buf),"หน้าจอ: %d",current_monitor+1);
-            render_monitor_text(buf,"ลง", FONT_SIZE);
-        }
-        last_down_state=val_down;
-
-        // ====== โค้ดปุ่ม UP ปกติ ======
-        if (val_up==1 && last_up_state!=1){
-            printf("UP pressed! Sending 'up' to monitor %d\n",current_monitor+1);
-            const char *msg="up";
-            if(sendto(sockfd,msg,strlen(msg),0,(struct sockaddr*)&dest_addr,sizeof(dest_addr))<0)
-                perror("Send failed");
-
-            char buf[32]; snprintf(buf,sizeof(buf),"หน้าจอ: %d",current_monitor+1);
-            render_monitor_text(buf,"ขึ้น", FONT_SIZE);
-        }
-        last_up_state=val_up;//                perror("Send failed");
-
-        // ปุ่ม DONE
-        int val_done = read_line_debounced(btn_done);
-        if(val_done==1 && last_done_state!=1){
-            printf("DONE pressed! Sending 'done' to monitor %d\n",current_monitor+1);
-            const char *msg="done";
-            if(sendto(sockfd,msg,strlen(msg),0,(struct sockaddr*)&dest_addr,sizeof(dest_addr))<0)
-                perror("Send failed");
-
-            char buf[32]; snprintf(buf,sizeof(buf),"หน้าจอ: %d",current_monitor+1);
-            render_monitor_text(buf,"เสร็จ", FONT_SIZE);
-        }
-        last_done_state = val_done;
-
-        // ปุ่ม monitor
-        for(int i=0;i<NUM_KEYS;i++){
-            int val=read_line_debounced(monitor_keys[i]);
-            if(val==0 && last_monitor_state[i]!=0){
-                set_monitor(i);
-                display_monitor_status(i);
-
-                // ส่งข้อความ UDP ไป monitor ที่เลือก
-                char msg[4];
-                snprintf(msg,sizeof(msg),"m%d",i+1);
-                if(sendto(sockfd,msg,strlen(msg),0,(struct sockaddr*)&dest_addr,sizeof(dest_addr))<0)
-                    perror("Send failed");
-
-                printf("เลือก monitor%d\n", i+1);
-
-                // แสดงผลบน OLED
-                char buf[32]; snprintf(buf,sizeof(buf),"หน้าจอ: %d",i+1);
-                render_monitor_text(buf,"เลือกจอ", FONT_SIZE);
-
-                // ✅ ควบคุม LED ตาม monitor
-                gpiod_line_set_value(led_red,   i==0 ? 1 : 0);   // monitor1 -> R
-                gpiod_line_set_value(led_yellow,i==1 ? 1 : 0);   // monitor2 -> Y
-                gpiod_line_set_value(led_green, i==2 ? 1 : 0);   // monitor3 -> G
-            }
-            last_monitor_state[i]=val;
-        }
-
-        // ปุ่ม monitor
-        int pressed_all = 1;
-        for(int i=0;i<NUM_KEYS;i++){
-            int val = read_line_debounced(monitor_keys[i]);
-            if(val != 0) pressed_all = 0;
-            last_monitor_state[i] = val;
-        }
-
-        if(pressed_all){
-            if(shutdown_start == 0){
-                shutdown_start = time(NULL);  // เริ่มจับเวลา
-                render_monitor_text("Hold 3s","เพื่อปิดเครื่อง", 18);  // แสดงบน OLED
-                last_blink = shutdown_start;
-            } else {
-                time_t now = time(NULL);
-
-                // กระพริบ LED ทุก 0.5 วินาที
-                if(difftime(now, last_blink) >= 0.5){
-                    led_blink_state = !led_blink_state;
-                    gpiod_line_set_value(led_red, led_blink_state);
-                    gpiod_line_set_value(led_yellow, led_blink_state);
-                    gpiod_line_set_value(led_green, led_blink_state);
-                    last_blink = now;
-                }
+    // ping ทุก monitor พร้อมกันใน thread แยก main loop อ่านผลจาก cache
+    int nmon = monitors_count();
+    struct sockaddr_in monitor_addrs[MONITOR_MAX];
+    int monitor_proto[MONITOR_MAX];
+    for(int i=0;i<nmon;i++){
+        monitor_addrs[i] = monitors_get(i)->addr;
+        monitor_proto[i] = monitors_get(i)->proto;
+    }
+    if(proto_init(sockfd, monitor_addrs, monitor_proto, nmon, on_cmd_lost) < 0) return 1;
+    if(health_start(monitor_addrs, nmon, config->probe_seq) < 0) return 1;
+    evloop_add(health_event_fd(), EPOLLIN, on_health, NULL);
+    // heartbeat/สถานะที่ monitor ส่งมาเอง (ลด ping และรู้ว่าหลุดได้เร็วกว่า)
+    // เปิด port ไม่ได้: ตาราง monitor ยังใช้ได้ ไม่มี heartbeat ก็ใช้ ping อย่างเดียว
+    if(status_rx_init(config->status_port, monitor_addrs, nmon, on_status) < 0) fprintf(stderr,"status receiver disabled\n");
+    // monitor ที่ไม่ได้อยู่ใน .env ตอบ broadcast/multicast แล้วถูกเพิ่มต่อท้าย
+    if(config->discovery_port > 0 &&
+       discovery_start(config->discovery_port, config->discovery_group[0] ? config->discovery_group : NULL, on_discovered) < 0)
+        fprintf(stderr,"discovery disabled\n");
+    // address ของเครื่องสำหรับหน้าจอ IP (rtnetlink ใน event loop นี้)
+    if(netinfo_start(on_netinfo) < 0) fprintf(stderr,"netinfo disabled\n");
+    // แก้ .env ระหว่างทำงาน: thread แยกอ่าน/ตรวจ/แปลง address แล้วส่งมาสลับที่ on_config
+    if(config_watch_start(".env", config) < 0 || evloop_add(config_event_fd(), EPOLLIN, on_config, NULL) < 0)
+        fprintf(stderr,"config reload disabled\n");
+    boot_mark("net");
+
+    debounce_timer = evtimer_new(on_debounce, NULL);
+    combo_timer    = evtimer_new(on_combo, NULL);
+    shutdown_timer = evtimer_new(on_shutdown, NULL);
+    blink_timer    = evtimer_new(on_blink, NULL);
+    scene_timer    = evtimer_new(on_scene_timer, NULL);
+    repeat_timer   = evtimer_new(on_repeat, NULL);
+    snapshot_timer = evtimer_new(on_snapshot, NULL);
+    if(!debounce_timer || !combo_timer || !shutdown_timer || !blink_timer || !scene_timer || !repeat_timer
+       || !snapshot_timer)
+        return 1;
 
-                // ถ้าค้าง >= 3 วินาที -> Shutdown
-                if(difftime(now, shutdown_start) >= 3.0){
-                    printf("กดปุ่มทั้ง 3 พร้อมกันค้าง 3 วินาที -> Shutdown\n");
-                    render_monitor_text("Shutdown","กำลังปิดเครื่อง", 18);
-                    system("shutdown -h now");
-                    return 0;
-                }
-            }
-        } else {
-          if(shutdown_start != 0){
-              // reset ถ้ามีปุ่มปล่อย
-              shutdown_start = 0;
-
-              // ปิด LED กระพริบ -> กลับปกติ
-              gpiod_line_set_value(led_red, 0);
-              gpiod_line_set_value(led_yellow,0);
-              gpiod_line_set_value(led_green, 0);
-
-              // ล้างข้อความ OLED
-              render_monitor_text("","", FONT_SIZE);  
-
-              // ✅ ตั้ง monitor1 เป็นค่าเริ่มต้น
-              set_monitor(0);
-              display_monitor_status(0);
-
-              // ปรับ LED ตาม monitor1
-              gpiod_line_set_value(led_red,   1);   // monitor1 -> R
-              gpiod_line_set_value(led_yellow,0);
-              gpiod_line_set_value(led_green, 0);
-
-              // แสดงบน OLED ว่าเลือก monitor1
-              render_monitor_text("หน้าจอ: 1","เลือกจอ",FONT_SIZE);
-          }
-        }
+    // ฟอนต์ยังไม่พร้อม: scene เก็บข้อความไว้ก่อน splash ค้างบนจอจนถึง on_font_ready
+    scene_pause();
+    scene_init(oled);
+    if(oled_srv_start(config->display_socket, oled) < 0) fprintf(stderr,"display socket disabled\n");
 
-        // ตรวจสอบ connection ทุก 5 วินาที
-        if(difftime(time(NULL), last_check) >= 5){
-            oled_clear_line(56, 16); // เคลียร์แถวล่าง
+    display_monitor_status(current_monitor); // แสดง monitor เริ่มต้น (สถานะจะตามมาเมื่อ ping รอบแรกตอบ)
 
-            char buf[32];
-            snprintf(buf,sizeof(buf),"หน้าจอ: %d",current_monitor+1);
-            int connected = check_monitor();
-            char buf2[32];
-            snprintf(buf2,sizeof(buf2),connected?"เชื่อมต่อ":"            ");
-            render_monitor_text(buf,buf2, FONT_SIZE);
+    update_leds();
+    boot_mark("ui");
 
-            last_check = time(NULL);
-        }
+    // ไม่มี polling: process หลับอยู่ใน epoll_wait จนกว่าจะมี edge/datagram/timer
+    evloop_set_prepare(before_wait);
+    evloop_run();
 
-        usleep(20000);
-    }
+    if(font_fd >= 0) pthread_join(font_thread, NULL);  // ออกก่อนฟอนต์โหลดเสร็จ (shutdown ระหว่างบูต)
+    if(interrupted){ stop_all(); return 0; }
+    if(font_result < 0) return 1;
 
-    // Clean FreeType
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
+    // Clean ฟอนต์
+    font_done();
 
     return 0;
 }
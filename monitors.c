@@ -0,0 +1,128 @@
+#include "monitors.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+static monitor_t *table;
+static int count;
+static int cap;
+static monitor_group_t *groups;
+static int ngroups;
+
+int monitors_add(const struct sockaddr_in *addr,int proto,const char *name,int discovered){
+    if(count>=MONITOR_MAX){ fprintf(stderr,"monitors: table full (%d)\n",MONITOR_MAX); return -1; }
+    if(count==cap){
+        int ncap=cap ? cap*2 : 4;
+        monitor_t *t=realloc(table,ncap*sizeof(*t));
+        if(!t){ perror("monitors"); return -1; }
+        table=t;
+        cap=ncap;
+    }
+    monitor_t *m=&table[count];
+    memset(m,0,sizeof(*m));
+    m->addr=*addr;
+    m->proto=proto;
+    m->discovered=discovered;
+    inet_ntop(AF_INET,&addr->sin_addr,m->ip,sizeof(m->ip));
+    if(name) snprintf(m->name,sizeof(m->name),"%s",name);
+    return count++;
+}
+
+int monitors_make(monitor_t *m,const char *ip,int port,int proto,const char *name){
+    memset(m,0,sizeof(*m));
+    m->addr.sin_family=AF_INET;
+    m->addr.sin_port=htons(port);
+    if(inet_pton(AF_INET,ip,&m->addr.sin_addr)<=0) return -1;
+    m->proto=proto;
+    inet_ntop(AF_INET,&m->addr.sin_addr,m->ip,sizeof(m->ip));
+    if(name) snprintf(m->name,sizeof(m->name),"%s",name);
+    return 0;
+}
+
+int monitors_add_ip(const char *ip,int port,int proto,const char *name){
+    monitor_t m;
+    if(monitors_make(&m,ip,port,proto,name)<0){
+        fprintf(stderr,"Invalid address %s\n",ip);
+        return -1;
+    }
+    return monitors_add(&m.addr,proto,name,0);
+}
+
+int monitors_find(const struct sockaddr_in *addr){
+    for(int i=0;i<count;i++)
+        if(table[i].addr.sin_addr.s_addr==addr->sin_addr.s_addr && table[i].addr.sin_port==addr->sin_port) return i;
+    return -1;
+}
+
+int monitors_count(void){ return count; }
+
+const monitor_t *monitors_get(int idx){
+    if(idx<0 || idx>=count) return NULL;
+    return &table[idx];
+}
+
+int monitors_parse_group(monitor_group_t *g,const char *name,const char *list){
+    int bad=0;
+    memset(g,0,sizeof(*g));
+    snprintf(g->name,sizeof(g->name),"%s",name);
+    for(const char *p=list;*p;){
+        char *end;
+        long id=strtol(p,&end,10);
+        if(end==p){ bad++; break; }
+        if(id>=1 && id<=MONITOR_MAX && g->n<MONITOR_MAX) g->members[g->n++]=(int)id-1;
+        else bad++;
+        p=end;
+        while(*p==',' || *p==' ') p++;
+    }
+    return g->n==0 ? -1 : bad;
+}
+
+int monitors_add_group(const char *name,const char *list){
+    monitor_group_t g;
+    int bad=monitors_parse_group(&g,name,list);
+    if(bad<0){ fprintf(stderr,"group %s: no monitors\n",name); return -1; }
+    if(bad) fprintf(stderr,"group %s: %d bad monitor(s) skipped\n",name,bad);
+
+    monitor_group_t *t=realloc(groups,(ngroups+1)*sizeof(*t));
+    if(!t){ perror("monitors"); return -1; }
+    groups=t;
+    groups[ngroups]=g;
+    return ngroups++;
+}
+
+int monitors_group_count(void){ return ngroups; }
+
+const monitor_group_t *monitors_group(int g){
+    if(g<0 || g>=ngroups) return NULL;
+    return &groups[g];
+}
+
+int monitors_replace(const monitor_t *t,int n,const monitor_group_t *g,int ng){
+    if(n<0 || n>MONITOR_MAX || ng<0) return -1;
+    // สร้างตารางใหม่ให้ครบก่อน แล้วค่อยสลับ: ถ้า memory ไม่พอ ของเดิมยังอยู่ครบ
+    int ncap=n ? n : 4;
+    monitor_t *nt=malloc(ncap*sizeof(*nt));
+    monitor_group_t *ngr=ng ? malloc(ng*sizeof(*ngr)) : NULL;
+    if(!nt || (ng && !ngr)){ perror("monitors"); free(nt); free(ngr); return -1; }
+    memcpy(nt,t,n*sizeof(*nt));
+    if(ng) memcpy(ngr,g,ng*sizeof(*ngr));
+
+    free(table);
+    free(groups);
+    table=nt;
+    count=n;
+    cap=ncap;
+    groups=ngr;
+    ngroups=ng;
+    return 0;
+}
+
+void monitors_clear(void){
+    free(table);
+    table=NULL;
+    count=cap=0;
+    free(groups);
+    groups=NULL;
+    ngroups=0;
+}
@@ -0,0 +1,60 @@
+#ifndef MONITORS_H
+#define MONITORS_H
+
+#include <netinet/in.h>
+
+// จำนวน monitor สูงสุดที่ module อื่น (health, proto, status_rx) จองช่องไว้
+// ตารางของ registry เองโตตามจำนวนที่มีจริง
+#ifndef MONITOR_MAX
+#define MONITOR_MAX 64
+#endif
+#define MONITOR_NAME_MAX 24
+
+// monitor หนึ่งตัว: address แปลงไว้แล้วตอนเพิ่ม เปลี่ยนจอจึงเป็นแค่เปลี่ยน index
+typedef struct {
+    struct sockaddr_in addr;
+    int proto;                      // PROTO_ASCII / PROTO_BINARY
+    int discovered;                 // 1 = ได้มาจาก discovery ไม่ได้อยู่ใน .env
+    char ip[INET_ADDRSTRLEN];       // ไว้แสดง/log
+    char name[MONITOR_NAME_MAX];
+} monitor_t;
+
+// กลุ่มของ monitor ที่สั่งพร้อมกันได้ (GROUP_<name>=1,2,5 ใน .env)
+// members เก็บ index (เลข monitor - 1) ตัวที่ยังไม่มีในตารางถูกข้ามตอนส่ง (อาจมาจาก discovery ทีหลัง)
+typedef struct {
+    char name[MONITOR_NAME_MAX];
+    int n;
+    int members[MONITOR_MAX];
+} monitor_group_t;
+
+// เพิ่ม monitor คืน index หรือ -1 ถ้าเต็ม MONITOR_MAX
+int monitors_add(const struct sockaddr_in *addr,int proto,const char *name,int discovered);
+
+// แปลง "ip" + port ใส่ *m (ยังไม่เพิ่มในตาราง) คืน -1 ถ้า address ผิด
+int monitors_make(monitor_t *m,const char *ip,int port,int proto,const char *name);
+
+// แปลง "ip" + port แล้วเพิ่ม คืน index, -1 ถ้า address ผิดหรือเต็ม
+int monitors_add_ip(const char *ip,int port,int proto,const char *name);
+
+// หา monitor ที่ address:port ตรงกัน คืน index หรือ -1
+int monitors_find(const struct sockaddr_in *addr);
+
+int monitors_count(void);
+
+// pointer ใช้ได้จนกว่าจะเพิ่ม monitor ครั้งถัดไป (ตารางอาจย้ายที่)
+const monitor_t *monitors_get(int idx);
+
+// list = เลข monitor คั่นด้วย ',' เช่น "1,2,5" คืน index ของกลุ่มหรือ -1 (เลขที่ผิดถูกข้าม)
+int monitors_add_group(const char *name,const char *list);
+// แปลง list ใส่ *g โดยไม่เพิ่มกลุ่ม คืนจำนวนเลขที่ผิด หรือ -1 ถ้าไม่เหลือสมาชิกเลย
+int monitors_parse_group(monitor_group_t *g,const char *name,const char *list);
+int monitors_group_count(void);
+const monitor_group_t *monitors_group(int g);
+
+// แทนทั้งตารางและกลุ่มในครั้งเดียว (config ใหม่) pointer จาก monitors_get/monitors_group เดิมใช้ไม่ได้อีก
+// คืน -1 ถ้า memory ไม่พอ (ตารางเดิมไม่เปลี่ยน)
+int monitors_replace(const monitor_t *t,int n,const monitor_group_t *g,int ng);
+
+void monitors_clear(void);
+
+#endif
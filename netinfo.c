@@ -0,0 +1,255 @@
+#include "netinfo.h"
+#include "evloop.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_addr.h>
+
+typedef struct {
+    int index;                  // ifindex (0 = ช่องว่าง)
+    unsigned flags;             // IFF_*
+    char name[IF_NAMESIZE];
+} link_t;
+
+typedef struct {
+    int index;                  // 0 = ช่องว่าง
+    int family;
+    int prefix;
+    unsigned flags;             // IFA_F_*
+    unsigned char addr[16];
+} addr_t;
+
+static link_t links[NETINFO_LINKS];
+static addr_t addrs[NETINFO_ADDRS];
+
+static int sock=-1;
+static void (*change_cb)(void);
+static uint32_t seq;
+static int dumping;             // RTM_GETLINK / RTM_GETADDR ที่รอ NLMSG_DONE (0 = ไม่มี)
+static uint32_t dump_seq;       // nlmsg_seq ของ dump นั้น (DONE/ERROR ของ seq อื่นไม่เกี่ยว)
+static int redump;              // ENOBUFS ระหว่าง dump: dump ใหม่ทั้งหมดเมื่อ dump นี้จบ
+static int ready;
+static int pending;             // ตารางเปลี่ยนแล้วยังไม่ได้เรียก change_cb (รอ dump เสร็จ)
+
+// ขอ dump ทั้งตาราง: link ก่อน address จะได้รู้ชื่อ interface ก่อน
+static int request_dump(int type){
+    struct { struct nlmsghdr nh; struct rtgenmsg g; } req;
+    memset(&req,0,sizeof(req));
+    req.nh.nlmsg_len=sizeof(req);
+    req.nh.nlmsg_type=type;
+    req.nh.nlmsg_flags=NLM_F_REQUEST|NLM_F_DUMP;
+    req.nh.nlmsg_seq=++seq;
+    req.g.rtgen_family=AF_UNSPEC;
+    struct sockaddr_nl k={ .nl_family=AF_NETLINK };
+    if(sendto(sock,&req,sizeof(req),0,(struct sockaddr*)&k,sizeof(k))<0){ perror("netinfo dump"); return -1; }
+    dumping=type;
+    dump_seq=req.nh.nlmsg_seq;
+    return 0;
+}
+
+// event หายไป (ENOBUFS): ตารางอาจไม่ตรงแล้ว ล้างแล้ว dump ใหม่ทั้งหมด
+static int restart_dump(void){
+    memset(links,0,sizeof(links));
+    memset(addrs,0,sizeof(addrs));
+    ready=0;
+    pending=1;
+    return request_dump(RTM_GETLINK);
+}
+
+static link_t *find_link(int index){
+    for(int i=0;i<NETINFO_LINKS;i++) if(links[i].index==index) return &links[i];
+    return NULL;
+}
+
+static link_t *link_by_name(const char *name){
+    for(int i=0;i<NETINFO_LINKS;i++)
+        if(links[i].index && strcmp(links[i].name,name)==0) return &links[i];
+    return NULL;
+}
+
+static void drop_addrs(int index){
+    for(int i=0;i<NETINFO_ADDRS;i++) if(addrs[i].index==index) addrs[i].index=0;
+}
+
+// คืน 1 ถ้าตารางเปลี่ยน
+static int on_link(const struct nlmsghdr *nh){
+    const struct ifinfomsg *ifi=NLMSG_DATA(nh);
+    int len=IFLA_PAYLOAD(nh);
+    link_t *l=find_link(ifi->ifi_index);
+
+    if(nh->nlmsg_type==RTM_DELLINK){
+        if(!l) return 0;
+        drop_addrs(l->index);
+        l->index=0;
+        return 1;
+    }
+
+    char name[IF_NAMESIZE]="";
+    for(const struct rtattr *a=IFLA_RTA(ifi);RTA_OK(a,len);a=RTA_NEXT(a,len))
+        if(a->rta_type==IFLA_IFNAME) snprintf(name,sizeof(name),"%s",(const char*)RTA_DATA(a));
+
+    if(!l){
+        l=find_link(0);
+        if(!l){ fprintf(stderr,"netinfo: more than %d interfaces\n",NETINFO_LINKS); return 0; }
+    }
+    else if(l->flags==ifi->ifi_flags && (!*name || strcmp(l->name,name)==0)) return 0;
+    l->index=ifi->ifi_index;
+    l->flags=ifi->ifi_flags;
+    if(*name) memcpy(l->name,name,sizeof(name));
+    return 1;
+}
+
+static int on_addr(const struct nlmsghdr *nh){
+    const struct ifaddrmsg *ifa=NLMSG_DATA(nh);
+    int len=IFA_PAYLOAD(nh);
+    if(ifa->ifa_family!=AF_INET && ifa->ifa_family!=AF_INET6) return 0;
+
+    // IPv4 แบบ point-to-point: IFA_ADDRESS คือปลายทาง address ของเราอยู่ใน IFA_LOCAL
+    addr_t n={ .index=ifa->ifa_index, .family=ifa->ifa_family, .prefix=ifa->ifa_prefixlen, .flags=ifa->ifa_flags };
+    const void *local=NULL, *address=NULL;
+    for(const struct rtattr *a=IFA_RTA(ifa);RTA_OK(a,len);a=RTA_NEXT(a,len)){
+        if(a->rta_type==IFA_LOCAL) local=RTA_DATA(a);
+        else if(a->rta_type==IFA_ADDRESS) address=RTA_DATA(a);
+        else if(a->rta_type==IFA_FLAGS) n.flags=*(const uint32_t*)RTA_DATA(a);
+    }
+    if(!local) local=address;
+    if(!local) return 0;
+    memcpy(n.addr,local,n.family==AF_INET?4:16);
+
+    addr_t *slot=NULL, *free_slot=NULL;
+    for(int i=0;i<NETINFO_ADDRS;i++){
+        addr_t *e=&addrs[i];
+        if(!e->index){ if(!free_slot) free_slot=e; continue; }
+        if(e->index==n.index && e->family==n.family && e->prefix==n.prefix
+           && memcmp(e->addr,n.addr,sizeof(n.addr))==0){ slot=e; break; }
+    }
+
+    if(nh->nlmsg_type==RTM_DELADDR){
+        if(!slot) return 0;
+        slot->index=0;
+        return 1;
+    }
+    if(slot) return slot->flags!=n.flags ? (slot->flags=n.flags,1) : 0;
+    if(!free_slot){ fprintf(stderr,"netinfo: more than %d addresses\n",NETINFO_ADDRS); return 0; }
+    *free_slot=n;
+    return 1;
+}
+
+static void on_netlink(int fd,uint32_t events,void *ctx){
+    (void)events; (void)ctx;
+    char buf[8192] __attribute__((aligned(NLMSG_ALIGNTO)));
+    for(;;){
+        ssize_t n=recv(fd,buf,sizeof(buf),MSG_DONTWAIT);
+        if(n<0){
+            if(errno==EAGAIN || errno==EWOULDBLOCK) break;
+            // kernel ส่ง event เร็วกว่าที่อ่าน (ENOBUFS) ถ้ามี dump ค้างอยู่ kernel ไม่รับ dump ซ้อน (EBUSY)
+            // จึงรอ DONE ของ dump นั้นก่อน
+            if(errno==ENOBUFS){
+                if(dumping) redump=1;
+                else if(restart_dump()<0) break;
+                continue;
+            }
+            perror("netinfo recv");
+            break;
+        }
+        int len=n;
+        for(struct nlmsghdr *nh=(struct nlmsghdr*)buf;NLMSG_OK(nh,len);nh=NLMSG_NEXT(nh,len)){
+            switch(nh->nlmsg_type){
+            case NLMSG_DONE:
+                if(!dumping || nh->nlmsg_seq!=dump_seq) break;
+                if(redump){ redump=0; restart_dump(); }
+                else if(dumping==RTM_GETLINK) request_dump(RTM_GETADDR);
+                else{ dumping=0; ready=1; pending=1; }
+                break;
+            case NLMSG_ERROR:{
+                const struct nlmsgerr *e=NLMSG_DATA(nh);
+                if(!e->error) break;
+                errno=-e->error;
+                perror("netinfo");
+                if(dumping && nh->nlmsg_seq==dump_seq) dumping=0;   // dump นี้ไม่มี DONE แล้ว
+                break;
+            }
+            case RTM_NEWLINK: case RTM_DELLINK: pending|=on_link(nh); break;
+            case RTM_NEWADDR: case RTM_DELADDR: pending|=on_addr(nh); break;
+            }
+        }
+    }
+    if(ready && pending){
+        pending=0;
+        if(change_cb) change_cb();
+    }
+}
+
+int netinfo_start(void (*on_change)(void)){
+    change_cb=on_change;
+    sock=socket(AF_NETLINK,SOCK_RAW|SOCK_NONBLOCK|SOCK_CLOEXEC,NETLINK_ROUTE);
+    if(sock<0){ perror("netinfo socket"); return -1; }
+    struct sockaddr_nl a={ .nl_family=AF_NETLINK,
+                           .nl_groups=RTMGRP_LINK|RTMGRP_IPV4_IFADDR|RTMGRP_IPV6_IFADDR };
+    if(bind(sock,(struct sockaddr*)&a,sizeof(a))<0 || request_dump(RTM_GETLINK)<0){
+        perror("netinfo bind");
+        close(sock);
+        sock=-1;
+        return -1;
+    }
+    return evloop_add(sock,EPOLLIN,on_netlink,NULL);
+}
+
+void netinfo_stop(void){
+    if(sock<0) return;
+    evloop_del(sock);
+    close(sock);
+    sock=-1;
+}
+
+int netinfo_ready(void){ return ready; }
+
+int netinfo_link_up(const char *ifname){
+    const link_t *l=link_by_name(ifname);
+    if(!l) return -1;
+    return (l->flags&(IFF_UP|IFF_RUNNING))==(IFF_UP|IFF_RUNNING);
+}
+
+// address ที่เหมาะจะแสดง: IPv4 ที่ไม่ใช่ secondary, IPv6 global ที่พร้อมใช้และไม่ใช่ temporary
+static int usable(const addr_t *e){
+    if(e->family==AF_INET) return !(e->flags&IFA_F_SECONDARY);
+    const struct in6_addr *a=(const struct in6_addr*)e->addr;
+    if(IN6_IS_ADDR_LINKLOCAL(a) || IN6_IS_ADDR_LOOPBACK(a)) return 0;
+    return !(e->flags&(IFA_F_TENTATIVE|IFA_F_DEPRECATED|IFA_F_TEMPORARY|IFA_F_DADFAILED));
+}
+
+int netinfo_addr(const char *ifname,char *buf,size_t len){
+    const link_t *l=link_by_name(ifname);
+    if(!l) return -1;
+    const addr_t *best=NULL;
+    for(int i=0;i<NETINFO_ADDRS;i++){
+        const addr_t *e=&addrs[i];
+        if(e->index!=l->index || !usable(e)) continue;
+        if(!best || (e->family==AF_INET && best->family!=AF_INET)) best=e;
+    }
+    if(!best || !inet_ntop(best->family,best->addr,buf,len)) return -1;
+    return best->family;
+}
+
+int netinfo_addrs(const char *ifname,char *buf,size_t len){
+    const link_t *l=link_by_name(ifname);
+    int n=0;
+    size_t off=0;
+    if(len) buf[0]=0;
+    if(!l) return 0;
+    for(int i=0;i<NETINFO_ADDRS;i++){
+        const addr_t *e=&addrs[i];
+        char text[INET6_ADDRSTRLEN];
+        if(e->index!=l->index || !inet_ntop(e->family,e->addr,text,sizeof(text))) continue;
+        off+=snprintf(buf+off,len-off,"%s%s/%d",n?" ":"",text,e->prefix);
+        if(off>len) off=len;            // ตัดแล้ว: buf+off ต้องไม่เลยท้าย buffer
+        n++;
+    }
+    return n;
+}
@@ -0,0 +1,33 @@
+#ifndef NETINFO_H
+#define NETINFO_H
+
+#include <stddef.h>
+
+#ifndef NETINFO_LINKS
+#define NETINFO_LINKS 16
+#endif
+#ifndef NETINFO_ADDRS
+#define NETINFO_ADDRS 48
+#endif
+
+// ตาราง interface/address ของเครื่องจาก rtnetlink (RTM_GETLINK/GETADDR ตอนเริ่ม แล้วตาม event ของ kernel)
+// อยู่ใน event loop ทั้งหมด หน้าจอ IP อ่านจากตารางนี้ ไม่มี syscall ตอนกดปุ่ม
+// on_change ถูกเรียกเมื่อ dump ครั้งแรกเสร็จ และหลังอ่าน event ชุดหนึ่งที่ทำให้ตารางเปลี่ยน
+// (ตอน dump ยังไม่เสร็จไม่เรียก ตารางยังไม่ครบ)
+int netinfo_start(void (*on_change)(void));
+void netinfo_stop(void);
+
+// 1 = dump ครั้งแรกเสร็จแล้ว (ก่อนหน้านั้นตารางยังไม่ครบ)
+int netinfo_ready(void);
+
+// 1 = interface เปิดและมีสาย (IFF_UP + IFF_RUNNING), 0 = ไม่ได้, -1 = ไม่มี interface นี้
+int netinfo_link_up(const char *ifname);
+
+// address หลักของ interface เป็นข้อความ: IPv4 ตัวแรก (ไม่ใช่ secondary) ถ้าไม่มีใช้ IPv6 global
+// (ไม่ใช่ tentative/deprecated/temporary) คืน address family หรือ -1 ถ้าไม่มี
+int netinfo_addr(const char *ifname,char *buf,size_t len);
+
+// ทุก address ของ interface คั่นด้วย ' ' ("addr/prefix") คืนจำนวน
+int netinfo_addrs(const char *ifname,char *buf,size_t len);
+
+#endif
@@ -1,104 +1,645 @@
 #include "oled_i2c.h"
+#include "font.h"
+#include "metrics.h"
+#include "i2c_bus.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <fcntl.h>
-#include <unistd.h>
 #include <string.h>
-#include <sys/ioctl.h>
-#include <linux/i2c-dev.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// ช่วง column ที่ถูกแก้ในแต่ละ page (lo>hi = ไม่ dirty)
+typedef struct {
+    uint16_t lo[OLED_MAX_PAGES];        // 16 bit: canvas กว้างกว่า 256 ได้
+    uint16_t hi[OLED_MAX_PAGES];
+} dirty_t;
+
+// ช่วงที่ต้องส่ง: column lo..hi ของ page p0..p1 (หลาย page ได้เฉพาะแบบเต็มความกว้าง)
+struct span { int off,len; uint8_t lo,hi,p0,p1; uint8_t saved; uint8_t cmd[7]; };
+
+struct oled_bus;
+
+struct oled {
+    struct oled_bus *bus;               // NULL = canvas (วาดอย่างเดียว ไม่มีจอ)
+    struct oled *next;                  // จอถัดไปบนบัสเดียวกัน
+    i2c_bus_t *i2c;
+    uint16_t addr;
+    int width, height, pages, fb_size;
+
+    // ฝั่งวาด (thread ที่เรียก oled_draw_*): back buffer + ช่วงที่แก้ตั้งแต่ oled_display() ครั้งก่อน
+    uint8_t *buffer;
+    dirty_t draw_dirty;
+    int clip_x0, clip_y0, clip_x1, clip_y1;     // พื้นที่ที่อนุญาตให้วาด (รวมขอบ)
+    uint8_t *saved;                     // ภาพที่ oled_save เขียนลงไฟล์ครั้งล่าสุด
+    int saved_valid;
+
+    // frame ที่ส่งให้ thread ของบัส: [0] คือ control byte 0x40 ตามด้วย framebuffer
+    // ทำให้ส่งออกไปได้ตรงๆ ไม่ต้อง copy อีกรอบ (ตัวแปรชุดนี้ใช้ภายใต้ bus->lock)
+    uint8_t *frames[2];
+    uint8_t *pending;                   // frame ล่าสุดที่วาดเสร็จ รอส่ง
+    uint8_t *front;                     // frame ที่กำลังส่ง
+    dirty_t pending_dirty;
+    int pending_ready;
+    int flushing;                       // ส่ง front ไปแล้วบางส่วน (ผลัดกับจออื่นบนบัส)
+    int force_full;
+    int need_init;                      // ยังไม่ได้ส่ง init sequence
+    oled_stats_t stats;
 
-#define OLED_WIDTH 128
-#define OLED_HEIGHT 64
-#define OLED_ADDR 0x3C
+    // ฝั่ง thread ของบัสเท่านั้น
+    uint8_t *shadow;                    // สำเนาสิ่งที่อยู่บน OLED จริง
+    int shadow_valid;                   // 0 = ยังไม่รู้ว่าบนจอมีอะไร ต้องส่งทั้งจอ
+    int xfer_failed;                    // มี transaction ที่ส่งไม่สำเร็จตั้งแต่ frame/init ก่อน
+    dirty_t front_dirty;
+    struct span sp[OLED_MAX_PAGES];     // แผนส่งของ front และ span ถัดไปที่ยังไม่ได้ส่ง
+    int nspan, next_span;
+    uint32_t cur_bytes, cur_transactions;
+    uint64_t t0;
+};
 
-static int i2c_fd = -1;
-static uint8_t buffer[OLED_WIDTH*OLED_HEIGHT/8];
+// บัส I2C หนึ่งเส้น (ตาม path) มี thread ส่งของตัวเอง บัสต่างกันจึงส่งพร้อมกันได้
+struct oled_bus {
+    char path[64];
+    struct oled_bus *next;
+    oled_t *panels;
+    oled_t *turn;                       // round robin: จอที่ได้ดูก่อนในรอบถัดไป
+    int stop;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t frame_cond;          // มี frame ใหม่/จอใหม่
+    pthread_cond_t idle_cond;           // จอใดจอหนึ่งส่งหมดแล้ว
+};
 
+static struct oled_bus *buses;
+static pthread_mutex_t buses_lock = PTHREAD_MUTEX_INITIALIZER;
 
-// ส่งคำสั่งไป OLED
-static void oled_write_cmd(uint8_t cmd){
-    uint8_t data[2]={0x00,cmd};
-    write(i2c_fd,data,2);
+static void mark_dirty(dirty_t *d,int page,int x0,int x1){
+    if(x0<d->lo[page]) d->lo[page]=x0;
+    if(x1>d->hi[page]) d->hi[page]=x1;
 }
 
-// ส่ง data buffer ไป OLED
-static void oled_write_data(uint8_t *data,size_t len){
-    uint8_t tmp[len+1];
-    tmp[0]=0x40;
-    memcpy(tmp+1,data,len);
-    write(i2c_fd,tmp,len+1);
+static void mark_all_dirty(const oled_t *o,dirty_t *d){
+    for(int page=0;page<o->pages;page++) mark_dirty(d,page,0,o->width-1);
 }
 
-void oled_init(){
-    if((i2c_fd=open("/dev/i2c-0",O_RDWR))<0){ perror("i2c open"); exit(1); }
-    if(ioctl(i2c_fd,I2C_SLAVE,OLED_ADDR)<0){ perror("i2c ioctl"); exit(1); }
+static void clear_dirty(dirty_t *d){
+    memset(d->lo,0xFF,sizeof(d->lo));
+    memset(d->hi,0,sizeof(d->hi));
+}
 
-    memset(buffer,0,sizeof(buffer));
+// ส่งหลาย message เป็น transaction เดียวผ่าน backend ของบัส (i2c_dev.c / i2c_mem.c)
+static int i2c_xfer(oled_t *o,struct i2c_msg *msgs,int n){
+    for(int i=0;i<n;i++){
+        o->cur_bytes+=msgs[i].len;
+        o->cur_transactions++;
+    }
+    if(i2c_bus_xfer(o->i2c,msgs,n)<0){ o->xfer_failed=1; return -1; }
+    return 0;
+}
 
-    // Init sequence SSD1306
-    oled_write_cmd(0xAE); oled_write_cmd(0x20); oled_write_cmd(0x00);
-    oled_write_cmd(0xB0); oled_write_cmd(0xC8); oled_write_cmd(0x00);
-    oled_write_cmd(0x10); oled_write_cmd(0x40); oled_write_cmd(0x81);
-    oled_write_cmd(0xFF); oled_write_cmd(0xA1); oled_write_cmd(0xA6);
-    oled_write_cmd(0xA8); oled_write_cmd(0x3F); oled_write_cmd(0xA4);
-    oled_write_cmd(0xD3); oled_write_cmd(0x00); oled_write_cmd(0xD5);
-    oled_write_cmd(0xF0); oled_write_cmd(0xD9); oled_write_cmd(0x22);
-    oled_write_cmd(0xDA); oled_write_cmd(0x12); oled_write_cmd(0xDB);
-    oled_write_cmd(0x20); oled_write_cmd(0x8D); oled_write_cmd(0x14);
-    oled_write_cmd(0xAF);
+// ส่งชุดคำสั่งเป็น transaction เดียว: 0x00 ตามด้วย command byte ทั้งหมด
+static int oled_write_cmds(oled_t *o,const uint8_t *cmds,size_t n){
+    uint8_t data[32];
+    if(n+1>sizeof(data)) return -1;
+    data[0]=0x00;
+    memcpy(data+1,cmds,n);
+    struct i2c_msg msg={ .addr=o->addr, .flags=0, .len=n+1, .buf=data };
+    return i2c_xfer(o,&msg,1);
 }
 
-void oled_clear(){ memset(buffer,0,sizeof(buffer)); }
+// Init sequence SSD1306 (horizontal addressing mode) ส่งเป็นก้อนเดียว
+// multiplex และ COM pins ตามความสูงของจอ (128x32 ใช้ COM แบบ sequential)
+static void send_init(oled_t *o){
+    uint8_t init_seq[]={
+        0xAE, 0x20, 0x00, 0xB0, 0xC8, 0x00, 0x10, 0x40,
+        0x81, 0xFF, 0xA1, 0xA6, 0xA8, o->height-1, 0xA4, 0xD3,
+        0x00, 0xD5, 0xF0, 0xD9, 0x22, 0xDA, o->height==32?0x02:0x12, 0xDB,
+        0x20, 0x8D, 0x14, 0xAF,
+    };
+    o->cur_bytes=o->cur_transactions=0;
+    oled_write_cmds(o,init_seq,sizeof(init_seq));
+    o->shadow_valid=0;
+}
 
-void oled_display(){
-    for(int page=0;page<8;page++){
-        oled_write_cmd(0xB0+page);
-        oled_write_cmd(0x00); oled_write_cmd(0x10);
-        oled_write_data(&buffer[OLED_WIDTH*page],OLED_WIDTH);
+// ส่งชุด span ใน ioctl เดียว data ส่งตรงจาก frame
+// โดยยืม byte ก่อนหน้าช่วงมาเป็น control byte 0x40 ชั่วคราว แล้วคืนค่าหลังส่ง
+static void send_spans(oled_t *o,uint8_t *frame,struct span *sp,int nspan){
+    struct i2c_msg msgs[2*OLED_MAX_PAGES];
+    int n=0;
+    for(int i=0;i<nspan;i++){
+        uint8_t *c=sp[i].cmd;
+        c[0]=0x00; c[1]=0x21; c[2]=sp[i].lo; c[3]=sp[i].hi;
+        c[4]=0x22; c[5]=sp[i].p0; c[6]=sp[i].p1;
+        msgs[n++]=(struct i2c_msg){ .addr=o->addr, .flags=0, .len=7, .buf=c };
+
+        sp[i].saved=frame[sp[i].off];
+        frame[sp[i].off]=0x40;
+        msgs[n++]=(struct i2c_msg){ .addr=o->addr, .flags=0, .len=sp[i].len+1, .buf=&frame[sp[i].off] };
     }
+    i2c_xfer(o,msgs,n);
+    for(int i=nspan-1;i>=0;i--) frame[sp[i].off]=sp[i].saved;
 }
 
-void oled_draw_pixel(int x,int y,uint8_t color){
-    if(x<0||x>=OLED_WIDTH||y<0||y>=OLED_HEIGHT) return;
-    int page=y/8; int bit=y%8;
-    if(color) buffer[page*OLED_WIDTH+x]|=(1<<bit);
-    else buffer[page*OLED_WIDTH+x]&=~(1<<bit);
+// วางแผนส่ง front: เฉพาะช่วงที่เปลี่ยนจริงของแต่ละ page
+static void plan_frame(oled_t *o){
+    const uint8_t *fb=o->front+1;
+    const dirty_t *d=&o->front_dirty;
+    int w=o->width;
+    o->nspan=o->next_span=0;
+
+    for(int page=0;page<o->pages;page++){
+        int lo=d->lo[page], hi=d->hi[page];
+        if(lo>hi) continue;
+
+        // ตัดส่วนหัว/ท้ายที่ตรงกับของบนจอแล้วทิ้ง
+        const uint8_t *row=&fb[w*page];
+        const uint8_t *old=&o->shadow[w*page];
+        if(o->shadow_valid){
+            while(lo<=hi && row[lo]==old[lo]) lo++;
+            while(hi>=lo && row[hi]==old[hi]) hi--;
+            if(lo>hi) continue;
+        }
+
+        // ต่อจาก span เต็มความกว้างของ page ก่อนหน้า -> ขยาย window เดิม
+        struct span *last=o->nspan?&o->sp[o->nspan-1]:NULL;
+        if(last && lo==0 && hi==w-1 && last->lo==0 && last->hi==w-1 && last->p1==page-1){
+            last->p1=page;
+            last->len+=w;
+            continue;
+        }
+        o->sp[o->nspan++]=(struct span){ .off=w*page+lo, .len=hi-lo+1,
+                                         .lo=lo, .hi=hi, .p0=page, .p1=page };
+    }
 }
 
-void oled_clear_line(int y,int height){
-    for(int row=y;row<y+height && row<OLED_HEIGHT;row++){
-        for(int col=0;col<OLED_WIDTH;col++){
-            oled_draw_pixel(col,row,0);
+// ส่ง span ที่เหลือไม่เกิน quantum byte (อย่างน้อยหนึ่งชุดเสมอ) คืน 1 ถ้าครบ frame
+// span หลาย page ที่ใหญ่กว่าส่วนที่เหลือถูกตัดส่งทีละกลุ่ม page จอถัดไปบนบัสไม่ต้องรอทั้ง frame
+static int send_some(oled_t *o,int quantum){
+    int sent=0;
+    while(o->next_span<o->nspan && sent<quantum){
+        int room=quantum-sent;
+        struct span *s=&o->sp[o->next_span];
+        if(s->len>room && s->p1>s->p0){
+            int np=room/o->width;
+            if(np<1) np=1;
+            if(np<=s->p1-s->p0){
+                struct span head=*s;
+                head.p1=s->p0+np-1;
+                head.len=np*o->width;
+                s->p0+=np; s->off+=head.len; s->len-=head.len;
+                send_spans(o,o->front,&head,1);
+                sent+=head.len;
+                continue;
+            }
+        }
+
+        // control byte ของ span ทับ byte สุดท้ายของ span ก่อนหน้า -> แยก ioctl
+        int start=o->next_span, i=start+1, bytes=s->len;
+        while(i<o->nspan && o->sp[i-1].off+o->sp[i-1].len!=o->sp[i].off
+              && bytes+o->sp[i].len<=room){
+            bytes+=o->sp[i].len;
+            i++;
         }
+        send_spans(o,o->front,&o->sp[start],i-start);
+        o->next_span=i;
+        sent+=bytes;
     }
+    return o->next_span==o->nspan;
 }
 
-// Render ข้อความด้วย FreeType
-void render_text(const char *text,int x_offset,int y_offset,FT_Face face){
-    while(*text){
-        uint32_t codepoint=0;
-        unsigned char c=text[0];
-        int len=1;
-        if(c<0x80) codepoint=c;
-        else if((c&0xE0)==0xC0){ codepoint=((c&0x1F)<<6)|(text[1]&0x3F); len=2; }
-        else if((c&0xF0)==0xE0){ codepoint=((c&0x0F)<<12)|((text[1]&0x3F)<<6)|(text[2]&0x3F); len=3; }
-        else if((c&0xF8)==0xF0){ codepoint=((c&0x07)<<18)|((text[1]&0x3F)<<12)|((text[2]&0x3F)<<6)|(text[3]&0x3F); len=4; }
-        else { text++; continue; }
-
-        if(FT_Load_Char(face,codepoint,FT_LOAD_RENDER)){ text+=len; continue; }
-
-        FT_GlyphSlot g=face->glyph;
-        for(int row=0;row<g->bitmap.rows;row++){
-            for(int col=0;col<g->bitmap.width;col++){
-                uint8_t pixel=g->bitmap.buffer[row*g->bitmap.pitch+col];
-                if(pixel>128){
-                    int px=x_offset+g->bitmap_left+col;
-                    int py=y_offset-g->bitmap_top+row;
-                    oled_draw_pixel(px,py,1);
+// จอตรงกับ front แล้ว ถ้ามี transaction ล้มเหลว (บัสสะดุด/จอหลุด) ไม่รู้ว่าจอมีอะไร frame ถัดไปส่งทั้งจอ
+static void finish_frame(oled_t *o){
+    const uint8_t *fb=o->front+1;
+    if(o->xfer_failed){
+        o->shadow_valid=0;
+        return;
+    }
+    for(int page=0;page<o->pages;page++){
+        if(o->front_dirty.lo[page]<=o->front_dirty.hi[page])
+            memcpy(&o->shadow[o->width*page],&fb[o->width*page],o->width);
+    }
+    o->shadow_valid=1;
+}
+
+static int has_work(const oled_t *o){ return o->need_init || o->pending_ready || o->flushing; }
+
+// จอถัดไปที่มีงาน เริ่มดูจาก b->turn วนรอบรายการ
+static oled_t *next_turn(struct oled_bus *b){
+    oled_t *start=b->turn?b->turn:b->panels, *o=start;
+    if(!o) return NULL;
+    do{
+        if(has_work(o)){
+            b->turn=o->next?o->next:b->panels;
+            return o;
+        }
+        o=o->next?o->next:b->panels;
+    }while(o!=start);
+    return NULL;
+}
+
+// thread ของบัส: ผลัดกันให้จอที่มีงานส่งครั้งละไม่เกิน OLED_FLUSH_QUANTUM byte
+// ถ้ามีจอเดียวที่รอ ส่งทั้ง frame รวดเดียวเหมือนจอเดี่ยว
+// frame ที่วาดมาระหว่างที่บัสยังไม่ว่างจะถูกทับ เหลือเฉพาะ frame ล่าสุดของแต่ละจอ
+static void *bus_main(void *arg){
+    struct oled_bus *b=arg;
+    pthread_mutex_lock(&b->lock);
+    for(;;){
+        oled_t *o;
+        while(!(o=next_turn(b)) && !b->stop) pthread_cond_wait(&b->frame_cond,&b->lock);
+        if(!o) break;
+
+        int contended=0;
+        for(oled_t *p=b->panels;p;p=p->next) if(p!=o && has_work(p)) contended=1;
+
+        int init=o->need_init, start=0;
+        if(!init && !o->flushing){
+            // สลับ pending <-> front แล้วปล่อย lock ระหว่างส่ง
+            uint8_t *tmp=o->front; o->front=o->pending; o->pending=tmp;
+            o->front_dirty=o->pending_dirty;
+            clear_dirty(&o->pending_dirty);
+            if(o->force_full){ o->shadow_valid=0; o->force_full=0; }
+            o->pending_ready=0;
+            o->flushing=1;
+            start=1;
+        }
+        pthread_mutex_unlock(&b->lock);
+
+        int done=0;
+        if(init) send_init(o);
+        else{
+            if(start){
+                o->cur_bytes=o->cur_transactions=0;
+                o->t0=metrics_now();
+                plan_frame(o);
+            }
+            done=send_some(o,contended?OLED_FLUSH_QUANTUM:INT_MAX);
+            if(done){
+                finish_frame(o);
+                if(o->cur_transactions){
+                    metrics_since(M_FLUSH,o->t0);
+                    metrics_add(M_FRAMES,1);
+                    metrics_add(M_BUS_BYTES,o->cur_bytes);
                 }
             }
         }
-        x_offset+=g->advance.x>>6;
-        text+=len;
+
+        pthread_mutex_lock(&b->lock);
+        if(init) o->need_init=0;
+        // ส่งไม่สำเร็จ: ส่วนที่ไม่ได้วาดใหม่ก็อาจหายไปจากจอ frame ถัดไปส่งทุก page
+        if((init || done) && o->xfer_failed){
+            o->xfer_failed=0;
+            mark_all_dirty(o,&o->pending_dirty);
+        }
+        if(done){
+            o->flushing=0;
+            o->stats.last_bytes=o->cur_bytes;
+            o->stats.last_transactions=o->cur_transactions;
+            if(o->cur_transactions){
+                o->stats.frames++;
+                o->stats.total_bytes+=o->cur_bytes;
+                o->stats.total_transactions+=o->cur_transactions;
+            }
+        }
+        if(!has_work(o)) pthread_cond_broadcast(&b->idle_cond);
+    }
+    pthread_mutex_unlock(&b->lock);
+    return NULL;
+}
+
+// บัสของ path (สร้าง thread ใหม่ถ้ายังไม่มี) เรียกภายใต้ buses_lock
+static struct oled_bus *bus_get(const char *path){
+    for(struct oled_bus *b=buses;b;b=b->next)
+        if(strcmp(b->path,path)==0) return b;
+
+    struct oled_bus *b=calloc(1,sizeof(*b));
+    if(!b){ perror("oled bus"); return NULL; }
+    snprintf(b->path,sizeof(b->path),"%s",path);
+    pthread_mutex_init(&b->lock,NULL);
+    pthread_cond_init(&b->frame_cond,NULL);
+    pthread_cond_init(&b->idle_cond,NULL);
+    if(pthread_create(&b->thread,NULL,bus_main,b)!=0){
+        perror("oled flush thread");
+        free(b);
+        return NULL;
+    }
+    b->next=buses;
+    buses=b;
+    return b;
+}
+
+oled_t *oled_open(const char *path,uint16_t addr,int width,int height){
+    if(width!=OLED_MAX_WIDTH || (height!=64 && height!=32)){
+        fprintf(stderr,"oled: unsupported size %dx%d (128x64 or 128x32)\n",width,height);
+        return NULL;
+    }
+    int fb_size=width*height/8;
+    // buffer, shadow, saved แล้วตามด้วย frame ส่งสองชุด (control byte 0x40 + framebuffer)
+    oled_t *o=calloc(1,sizeof(*o)+3*(size_t)fb_size+2*(1+(size_t)fb_size));
+    if(!o){ perror("oled"); return NULL; }
+    if(!(o->i2c=i2c_bus_open(path,addr))){ free(o); return NULL; }
+
+    o->addr=addr;
+    o->width=width;
+    o->height=height;
+    o->pages=height/8;
+    o->fb_size=fb_size;
+    o->buffer=(uint8_t*)(o+1);
+    o->shadow=o->buffer+fb_size;
+    o->saved=o->shadow+fb_size;
+    o->frames[0]=o->saved+fb_size;
+    o->frames[1]=o->frames[0]+1+fb_size;
+    o->frames[0][0]=o->frames[1][0]=0x40;
+    o->pending=o->frames[0];
+    o->front=o->frames[1];
+    clear_dirty(&o->draw_dirty);
+    clear_dirty(&o->pending_dirty);
+    mark_all_dirty(o,&o->draw_dirty);
+    oled_reset_clip(o);
+    o->need_init=1;
+
+    pthread_mutex_lock(&buses_lock);
+    struct oled_bus *b=bus_get(path);
+    if(b){
+        pthread_mutex_lock(&b->lock);
+        o->bus=b;
+        o->next=b->panels;
+        b->panels=o;
+        pthread_cond_signal(&b->frame_cond);
+        pthread_mutex_unlock(&b->lock);
+    }
+    pthread_mutex_unlock(&buses_lock);
+    if(!b){ i2c_bus_close(o->i2c); free(o); return NULL; }
+    return o;
+}
+
+void oled_close(oled_t *o){
+    if(!o) return;
+    if(!o->bus){ free(o); return; }
+    oled_sync(o);
+
+    struct oled_bus *b=o->bus;
+    pthread_mutex_lock(&buses_lock);
+    pthread_mutex_lock(&b->lock);
+    for(oled_t **pp=&b->panels;*pp;pp=&(*pp)->next){
+        if(*pp==o){ *pp=o->next; break; }
+    }
+    if(b->turn==o) b->turn=NULL;
+    int last=b->panels==NULL;
+    if(last){
+        b->stop=1;
+        pthread_cond_signal(&b->frame_cond);
+    }
+    pthread_mutex_unlock(&b->lock);
+    if(last){
+        pthread_join(b->thread,NULL);
+        for(struct oled_bus **pp=&buses;*pp;pp=&(*pp)->next){
+            if(*pp==b){ *pp=b->next; break; }
+        }
+        pthread_mutex_destroy(&b->lock);
+        pthread_cond_destroy(&b->frame_cond);
+        pthread_cond_destroy(&b->idle_cond);
+        free(b);
+    }
+    pthread_mutex_unlock(&buses_lock);
+
+    i2c_bus_close(o->i2c);
+    free(o);
+}
+
+// ใช้ struct เดียวกับจอ ฟังก์ชันวาดทั้งหมดใช้ได้ ส่วนที่เกี่ยวกับบัสไม่ทำอะไร
+oled_t *oled_canvas(int width,int height){
+    if(width<=0 || width>OLED_CANVAS_MAX_WIDTH || height<=0 || height>OLED_MAX_PAGES*8){
+        fprintf(stderr,"oled: unsupported canvas %dx%d\n",width,height);
+        return NULL;
+    }
+    int pages=(height+7)/8;
+    oled_t *o=calloc(1,sizeof(*o)+(size_t)width*pages);
+    if(!o){ perror("oled canvas"); return NULL; }
+    o->width=width;
+    o->height=height;
+    o->pages=pages;
+    o->fb_size=width*pages;
+    o->buffer=(uint8_t*)(o+1);
+    clear_dirty(&o->draw_dirty);
+    oled_reset_clip(o);
+    return o;
+}
+
+const uint8_t *oled_bits(const oled_t *o){ return o->buffer; }
+
+int oled_width(const oled_t *o){ return o->width; }
+int oled_height(const oled_t *o){ return o->height; }
+
+void oled_clear(oled_t *o){ memset(o->buffer,0,o->fb_size); mark_all_dirty(o,&o->draw_dirty); }
+
+// ส่ง back buffer ให้ thread ของบัส (ไม่รอ I2C)
+void oled_display(oled_t *o){
+    struct oled_bus *b=o->bus;
+    if(!b) return;
+    pthread_mutex_lock(&b->lock);
+    memcpy(o->pending+1,o->buffer,o->fb_size);
+    for(int page=0;page<o->pages;page++){
+        if(o->draw_dirty.lo[page]<=o->draw_dirty.hi[page])
+            mark_dirty(&o->pending_dirty,page,o->draw_dirty.lo[page],o->draw_dirty.hi[page]);
+    }
+    if(o->pending_ready) o->stats.dropped++;      // frame ก่อนหน้ายังไม่ได้ส่ง ถูกแทนที่
+    o->pending_ready=1;
+    pthread_cond_signal(&b->frame_cond);
+    pthread_mutex_unlock(&b->lock);
+    clear_dirty(&o->draw_dirty);
+}
+
+// รอจนกว่า frame ที่สั่งไว้ทั้งหมดของจอนี้ถูกส่งถึง OLED (ใช้ก่อนออกโปรแกรม/ปิดเครื่อง)
+void oled_sync(oled_t *o){
+    struct oled_bus *b=o->bus;
+    if(!b) return;
+    pthread_mutex_lock(&b->lock);
+    while(has_work(o)) pthread_cond_wait(&b->idle_cond,&b->lock);
+    pthread_mutex_unlock(&b->lock);
+}
+
+// บังคับให้ flush ครั้งถัดไปส่งทั้งจอ (เช่นหลัง OLED หลุด/ต่อใหม่)
+void oled_invalidate(oled_t *o){
+    if(!o->bus) return;
+    pthread_mutex_lock(&o->bus->lock);
+    o->force_full=1;
+    pthread_mutex_unlock(&o->bus->lock);
+    mark_all_dirty(o,&o->draw_dirty);
+}
+
+// เก็บ/โหลด back buffer เป็นไฟล์ขนาด framebuffer (ภาพล่าสุดไว้แสดงทันทีตอนเปิดเครื่องครั้งถัดไป)
+// เขียนไฟล์ชั่วคราวแล้ว rename ไฟฟ้าดับระหว่างเขียนไม่ทำให้ไฟล์เดิมเสีย
+int oled_save(oled_t *o,const char *path){
+    if(o->saved_valid && memcmp(o->saved,o->buffer,o->fb_size)==0) return 0;    // ไม่เขียน SD card ซ้ำ
+
+    char tmp[256];
+    snprintf(tmp,sizeof(tmp),"%s.tmp",path);
+    FILE *fp=fopen(tmp,"wb");
+    if(!fp){ perror(tmp); return -1; }
+    int ok=fwrite(o->buffer,1,o->fb_size,fp)==(size_t)o->fb_size;
+    ok&=fflush(fp)==0 && fsync(fileno(fp))==0;
+    ok&=fclose(fp)==0;
+    if(!ok || rename(tmp,path)<0){ perror(path); unlink(tmp); return -1; }
+    memcpy(o->saved,o->buffer,o->fb_size);
+    o->saved_valid=1;
+    return 0;
+}
+
+// ไฟล์ต้องมีขนาดตรงกับจอ (ภาพของจอ 128x64 ใช้กับจอ 128x32 ไม่ได้)
+int oled_load(oled_t *o,const char *path){
+    uint8_t fb[OLED_MAX_WIDTH*OLED_MAX_PAGES+1];
+    FILE *fp=fopen(path,"rb");
+    if(!fp) return -1;
+    int n=fread(fb,1,sizeof(fb),fp);
+    fclose(fp);
+    if(n!=o->fb_size) return -1;
+    memcpy(o->buffer,fb,o->fb_size);
+    mark_all_dirty(o,&o->draw_dirty);
+    return 0;
+}
+
+void oled_get_stats(oled_t *o,oled_stats_t *st){
+    if(!o->bus){ memset(st,0,sizeof(*st)); return; }
+    pthread_mutex_lock(&o->bus->lock);
+    *st=o->stats;
+    pthread_mutex_unlock(&o->bus->lock);
+}
+
+void oled_draw_pixel(oled_t *o,int x,int y,uint8_t color){
+    if(x<o->clip_x0||x>o->clip_x1||y<o->clip_y0||y>o->clip_y1) return;
+    int page=y/8; int bit=y%8;
+    if(color) o->buffer[page*o->width+x]|=(1<<bit);
+    else o->buffer[page*o->width+x]&=~(1<<bit);
+    mark_dirty(&o->draw_dirty,page,x,x);
+}
+
+// ---------- primitive แบบทำทีละ byte/64 bit บน layout page ของ SSD1306 ----------
+// clip ครั้งเดียวต่อ primitive แล้วทำงานเป็นแถบ column ต่อ page
+
+#define REP8(b) ((uint64_t)(uint8_t)(b)*0x0101010101010101ULL)
+
+enum { OP_CLEAR, OP_SET, OP_XOR };
+
+void oled_set_clip(oled_t *o,int x,int y,int w,int h){
+    o->clip_x0=x<0?0:x;
+    o->clip_y0=y<0?0:y;
+    o->clip_x1=x+w-1<o->width-1?x+w-1:o->width-1;
+    o->clip_y1=y+h-1<o->height-1?y+h-1:o->height-1;
+}
+
+void oled_reset_clip(oled_t *o){ oled_set_clip(o,0,0,o->width,o->height); }
+
+// bit ของแถวใน page ที่อยู่ในพื้นที่ clip
+static uint8_t clip_page_mask(const oled_t *o,int page){
+    int r0=o->clip_y0-page*8, r1=o->clip_y1-page*8;
+    if(r1<0 || r0>7) return 0;
+    if(r0<0) r0=0;
+    if(r1>7) r1=7;
+    return (uint8_t)((0xFF<<r0)&(0xFF>>(7-r1)));
+}
+
+static inline uint64_t load64(const uint8_t *p){ uint64_t v; memcpy(&v,p,8); return v; }
+static inline void store64(uint8_t *p,uint64_t v){ memcpy(p,&v,8); }
+
+// ใช้ mask (bit ของแถวใน page) กับ column x0..x1 ของ page เดียว
+static void apply_mask(uint8_t *row,int x0,int x1,uint8_t mask,int op){
+    int n=x1-x0+1;
+    uint8_t *p=row+x0;
+    if(mask==0xFF && op!=OP_XOR){ memset(p,op==OP_SET?0xFF:0x00,n); return; }
+
+    uint64_t m=REP8(mask);
+    int i=0;
+    for(;i+8<=n;i+=8){
+        uint64_t v=load64(p+i);
+        if(op==OP_SET) v|=m; else if(op==OP_CLEAR) v&=~m; else v^=m;
+        store64(p+i,v);
+    }
+    for(;i<n;i++){
+        if(op==OP_SET) p[i]|=mask; else if(op==OP_CLEAR) p[i]&=~mask; else p[i]^=mask;
+    }
+}
+
+static void rect_op(oled_t *o,int x,int y,int w,int h,int op){
+    if(w<=0 || h<=0) return;
+    int x0=x<o->clip_x0?o->clip_x0:x, x1=x+w-1<o->clip_x1?x+w-1:o->clip_x1;
+    int y0=y<o->clip_y0?o->clip_y0:y, y1=y+h-1<o->clip_y1?y+h-1:o->clip_y1;
+    if(x0>x1 || y0>y1) return;
+
+    for(int page=y0/8;page<=y1/8;page++){
+        int r0=page==y0/8?y0%8:0;
+        int r1=page==y1/8?y1%8:7;
+        uint8_t mask=(uint8_t)((0xFF<<r0)&(0xFF>>(7-r1)));
+        apply_mask(&o->buffer[page*o->width],x0,x1,mask,op);
+        mark_dirty(&o->draw_dirty,page,x0,x1);
+    }
+}
+
+void oled_fill_rect(oled_t *o,int x,int y,int w,int h,uint8_t color){ rect_op(o,x,y,w,h,color?OP_SET:OP_CLEAR); }
+void oled_invert_rect(oled_t *o,int x,int y,int w,int h){ rect_op(o,x,y,w,h,OP_XOR); }
+void oled_hline(oled_t *o,int x,int y,int w,uint8_t color){ rect_op(o,x,y,w,1,color?OP_SET:OP_CLEAR); }
+void oled_vline(oled_t *o,int x,int y,int h,uint8_t color){ rect_op(o,x,y,1,h,color?OP_SET:OP_CLEAR); }
+
+// OR bitmap 1bpp (layout page, w byte ต่อแถว page, สูง h) ลงที่ (x,y)
+// y ไม่ต้องตรง page: แต่ละ byte ถูก shift แล้วแยก OR ลงสอง page ที่คร่อมอยู่
+void oled_blit(oled_t *o,int x,int y,const uint8_t *bits,int w,int h){
+    int c0=x<o->clip_x0?o->clip_x0-x:0;
+    int c1=x+w>o->clip_x1+1?o->clip_x1+1-x:w;
+    if(w<=0 || h<=0 || c0>=c1 || y>o->clip_y1 || y+h<=o->clip_y0) return;
+
+    int shift=((y%8)+8)%8;
+    int dpage=(y-shift)/8;                  // page ของแถวแรก (ติดลบได้)
+    int n=c1-c0;
+
+    for(int sp=0;sp<(h+7)/8;sp++){
+        const uint8_t *src=&bits[sp*w+c0];
+        int p_lo=dpage+sp, p_hi=p_lo+1;
+        uint8_t m_lo=(p_lo>=0 && p_lo<o->pages)?clip_page_mask(o,p_lo)&(0xFF<<shift):0;
+        uint8_t m_hi=(shift && p_hi>=0 && p_hi<o->pages)?clip_page_mask(o,p_hi)&(0xFF>>(8-shift)):0;
+        if(!m_lo && !m_hi) continue;
+
+        uint8_t *lo=m_lo?&o->buffer[p_lo*o->width+x+c0]:NULL;
+        uint8_t *hi=m_hi?&o->buffer[p_hi*o->width+x+c0]:NULL;
+        uint64_t lo_mask=REP8(m_lo), hi_mask=REP8(m_hi);
+        int i=0;
+        for(;i+8<=n;i+=8){
+            uint64_t v=load64(src+i);
+            if(m_lo) store64(lo+i,load64(lo+i)|((v<<shift)&lo_mask));
+            if(m_hi) store64(hi+i,load64(hi+i)|((v>>(8-shift))&hi_mask));
+        }
+        for(;i<n;i++){
+            if(m_lo) lo[i]|=(uint8_t)(src[i]<<shift)&m_lo;
+            if(m_hi) hi[i]|=(uint8_t)(src[i]>>(8-shift))&m_hi;
+        }
+        if(m_lo) mark_dirty(&o->draw_dirty,p_lo,x+c0,x+c1-1);
+        if(m_hi) mark_dirty(&o->draw_dirty,p_hi,x+c0,x+c1-1);
+    }
+}
+
+void oled_clear_line(oled_t *o,int y,int height){
+    oled_fill_rect(o,0,y,o->width,height,0);
+}
+
+// Render ข้อความ (glyph มาจาก atlas หรือ cache, FreeType ถูกเรียกเฉพาะตอน miss)
+void render_text(oled_t *o,const char *text,int x_offset,int y_offset,int font_size){
+    uint64_t t0=metrics_now();
+    while(*text){
+        uint32_t codepoint=font_utf8_next(&text);
+        const glyph_t *g=codepoint ? font_glyph(font_size,codepoint) : NULL;
+        if(!g) continue;
+
+        oled_blit(o,x_offset+g->left,y_offset-g->top,g->bits,g->width,g->height);
+        x_offset+=g->advance;
+    }
+    metrics_since(M_RENDER,t0);
+}
+
+// ความกว้างของข้อความ (ผลรวม advance เท่ากับระยะที่ render_text เลื่อนไป)
+int render_text_width(const char *text,int font_size){
+    int w=0;
+    while(*text){
+        uint32_t codepoint=font_utf8_next(&text);
+        const glyph_t *g=codepoint ? font_glyph(font_size,codepoint) : NULL;
+        if(g) w+=g->advance;
     }
+    return w;
 }
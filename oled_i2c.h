@@ -2,14 +2,66 @@
 #define OLED_I2C_H
 
 #include <stdint.h>
-#include <ft2build.h>
-#include FT_FREETYPE_H
-
-void oled_init(void);
-void oled_clear(void);
-void oled_display(void);
-void oled_draw_pixel(int x,int y,uint8_t color);
-void render_text(const char *text,int x_offset,int y_offset,FT_Face face);
-void oled_clear_line(int y,int height);
+
+#ifndef OLED_BUS
+#define OLED_BUS "/dev/i2c-0"   // จอหลักของ monitor_control
+#endif
+#ifndef OLED_ADDR
+#define OLED_ADDR 0x3C
+#endif
+#ifndef OLED_FLUSH_QUANTUM
+#define OLED_FLUSH_QUANTUM 256  // byte ต่อรอบของจอหนึ่งตัว เมื่อหลายจอบนบัสเดียวกันรอส่งพร้อมกัน
+#endif
+#define OLED_MAX_WIDTH 128
+#define OLED_MAX_PAGES 8
+#ifndef OLED_CANVAS_MAX_WIDTH
+#define OLED_CANVAS_MAX_WIDTH 2048  // ภาพนอกจอ เช่นข้อความยาวที่เลื่อน (scene.c)
+#endif
+
+// สถิติการส่งข้อมูลบนบัส I2C (byte รวม control byte, transaction = 1 start/repeated start)
+typedef struct {
+    uint32_t frames;            // จำนวน flush ที่มีข้อมูลส่งจริง
+    uint32_t last_bytes;        // ของ flush ล่าสุด
+    uint32_t last_transactions;
+    uint64_t total_bytes;
+    uint64_t total_transactions;
+    uint32_t dropped;           // frame ที่ถูกแทนที่ก่อนได้ส่ง (วาดเร็วกว่าบัส)
+} oled_stats_t;
+
+// จอ SSD1306 หนึ่งตัว: framebuffer, clip และสถิติเป็นของจอเอง
+// จอบนบัสต่างกันส่งพร้อมกัน (thread ส่งหนึ่งตัวต่อบัส) จอที่ใช้บัสเดียวกันผลัดกันส่งรอบละ OLED_FLUSH_QUANTUM byte
+// จอเดียวกันวาดจาก thread เดียว (ฟังก์ชันวาดไม่มี lock) oled_display/oled_sync เรียกจาก thread ไหนก็ได้
+typedef struct oled oled_t;
+
+// bus = /dev/i2c-N, addr = 0x3C/0x3D, ขนาด 128x64 หรือ 128x32 คืน NULL ถ้าเปิดไม่ได้
+oled_t *oled_open(const char *bus,uint16_t addr,int width,int height);
+// รอส่ง frame ที่ค้างจนหมดแล้วปิด (thread ของบัสเลิกเมื่อไม่มีจอเหลือ)
+void oled_close(oled_t *o);
+// ภาพนอกจอขนาด width x height (ไม่เกิน 64) ใช้ฟังก์ชันวาดชุดเดียวกัน ปิดด้วย oled_close
+oled_t *oled_canvas(int width,int height);
+// framebuffer แบบ page (width byte ต่อ page) ส่งให้ oled_blit ของอีกภาพได้ตรงๆ
+const uint8_t *oled_bits(const oled_t *o);
+int oled_width(const oled_t *o);
+int oled_height(const oled_t *o);
+
+void oled_clear(oled_t *o);
+void oled_display(oled_t *o);
+void oled_sync(oled_t *o);
+void oled_invalidate(oled_t *o);
+void oled_get_stats(oled_t *o,oled_stats_t *st);
+// back buffer <-> ไฟล์ (ภาพล่าสุดสำหรับแสดงตอนเปิดเครื่อง) oled_save ไม่เขียนถ้าเหมือนครั้งก่อน
+int oled_save(oled_t *o,const char *path);
+int oled_load(oled_t *o,const char *path);
+void oled_set_clip(oled_t *o,int x,int y,int w,int h);
+void oled_reset_clip(oled_t *o);
+void oled_draw_pixel(oled_t *o,int x,int y,uint8_t color);
+void oled_fill_rect(oled_t *o,int x,int y,int w,int h,uint8_t color);
+void oled_invert_rect(oled_t *o,int x,int y,int w,int h);
+void oled_hline(oled_t *o,int x,int y,int w,uint8_t color);
+void oled_vline(oled_t *o,int x,int y,int h,uint8_t color);
+void oled_blit(oled_t *o,int x,int y,const uint8_t *bits,int w,int h);
+void render_text(oled_t *o,const char *text,int x_offset,int y_offset,int font_size);
+int render_text_width(const char *text,int font_size);
+void oled_clear_line(oled_t *o,int y,int height);
 
 #endif
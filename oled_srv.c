@@ -0,0 +1,269 @@
+#define _GNU_SOURCE
+#include "oled_srv.h"
+#include "scene.h"
+#include "evloop.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+typedef struct {
+    int fd;                 // socket ของ client (-1 = ว่าง)
+    int claimed;
+    int x, y, w, h;
+    int prio;
+    int timeout_ms;
+    uint32_t order;         // ลำดับการ claim
+    const uint8_t *shm;     // memfd ของ client (map อ่านอย่างเดียว)
+    size_t slot_size;
+    int shown;              // slot ที่แสดงอยู่ (-1 = ซ่อน)
+    int64_t until;          // ms (CLOCK_MONOTONIC) ที่ต้องซ่อน 0 = ไม่หมดเวลา
+} layer_t;
+
+static layer_t layers[OLED_SRV_CLIENTS];
+static oled_t *panel;
+static int listen_fd=-1;
+static char *sock_path;
+static evtimer_t *expire_timer;
+static uint32_t claims;
+
+static int64_t now_ms(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (int64_t)ts.tv_sec*1000+ts.tv_nsec/1000000;
+}
+
+static int above(const layer_t *a,const layer_t *b){
+    return a->prio!=b->prio ? a->prio>b->prio : a->order>b->order;
+}
+
+// วาด layer ที่แสดงอยู่จากล่างขึ้นบน (scene ตั้ง clip ไว้ที่สี่เหลี่ยมที่วาดใหม่แล้ว)
+static void paint(oled_t *o){
+    const layer_t *order[OLED_SRV_CLIENTS];
+    int n=0;
+    for(int i=0;i<OLED_SRV_CLIENTS;i++){
+        const layer_t *l=&layers[i];
+        if(l->fd<0 || l->shown<0) continue;
+        int j=n++;
+        while(j>0 && above(order[j-1],l)){ order[j]=order[j-1]; j--; }
+        order[j]=l;
+    }
+    for(int i=0;i<n;i++){
+        const layer_t *l=order[i];
+        oled_fill_rect(o,l->x,l->y,l->w,l->h,0);
+        oled_blit(o,l->x,l->y,l->shm+l->shown*l->slot_size,l->w,l->h);
+    }
+}
+
+static void damage(const layer_t *l){ scene_damage(l->x,l->y,l->w,l->h); }
+
+static void arm_expiry(void){
+    int64_t next=0;
+    for(int i=0;i<OLED_SRV_CLIENTS;i++){
+        const layer_t *l=&layers[i];
+        if(l->fd>=0 && l->shown>=0 && l->until && (!next || l->until<next)) next=l->until;
+    }
+    if(!next){ evtimer_disarm(expire_timer); return; }
+    int64_t ms=next-now_ms();
+    evtimer_arm(expire_timer,ms>0?(int)ms:1,0);
+}
+
+static void on_expire(void *ctx){
+    (void)ctx;
+    int64_t now=now_ms();
+    for(int i=0;i<OLED_SRV_CLIENTS;i++){
+        layer_t *l=&layers[i];
+        if(l->fd<0 || l->shown<0 || !l->until || now<l->until) continue;
+        l->shown=-1;
+        damage(l);
+    }
+    arm_expiry();
+}
+
+// ตอบหนึ่ง message (pass_fd >= 0 แนบ fd ไปด้วย) client ไม่อ่านจน buffer เต็ม = ทิ้งคำตอบ
+static void reply(int fd,int pass_fd,const char *fmt,...){
+    char buf[96];
+    va_list ap;
+    va_start(ap,fmt);
+    int n=vsnprintf(buf,sizeof(buf),fmt,ap);
+    va_end(ap);
+    if(n<0) return;
+    if(n>=(int)sizeof(buf)) n=sizeof(buf)-1;
+
+    struct iovec iov={ .iov_base=buf, .iov_len=n };
+    struct msghdr m={ .msg_iov=&iov, .msg_iovlen=1 };
+    union { char b[CMSG_SPACE(sizeof(int))]; struct cmsghdr align; } u;
+    if(pass_fd>=0){
+        memset(&u,0,sizeof(u));
+        m.msg_control=u.b;
+        m.msg_controllen=sizeof(u.b);
+        struct cmsghdr *c=CMSG_FIRSTHDR(&m);
+        c->cmsg_level=SOL_SOCKET;
+        c->cmsg_type=SCM_RIGHTS;
+        c->cmsg_len=CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(c),&pass_fd,sizeof(int));
+    }
+    sendmsg(fd,&m,MSG_DONTWAIT|MSG_NOSIGNAL);
+}
+
+// memfd ขนาดคงที่: seal แล้ว client ย่อไฟล์ไม่ได้ (controller อ่านแล้วไม่โดน SIGBUS)
+static int claim(layer_t *l,int x,int y,int w,int h){
+    if(w<=0 || h<=0 || x<0 || y<0 || x+w>oled_width(panel) || y+h>oled_height(panel)){
+        reply(l->fd,-1,"err region");
+        return -1;
+    }
+    size_t slot=(size_t)w*((h+7)/8);
+    int mfd=memfd_create("oled-layer",MFD_CLOEXEC|MFD_ALLOW_SEALING);
+    if(mfd<0){ perror("oled_srv memfd"); reply(l->fd,-1,"err memfd"); return -1; }
+    void *p=MAP_FAILED;
+    if(ftruncate(mfd,slot*OLED_SRV_SLOTS)==0
+       && fcntl(mfd,F_ADD_SEALS,F_SEAL_SHRINK|F_SEAL_GROW|F_SEAL_SEAL)==0)
+        p=mmap(NULL,slot*OLED_SRV_SLOTS,PROT_READ,MAP_SHARED,mfd,0);
+    if(p==MAP_FAILED){
+        perror("oled_srv memfd");
+        close(mfd);
+        reply(l->fd,-1,"err memfd");
+        return -1;
+    }
+
+    l->shm=p;
+    l->slot_size=slot;
+    l->x=x; l->y=y; l->w=w; l->h=h;
+    l->order=++claims;
+    l->claimed=1;
+    reply(l->fd,mfd,"ok %d %zu %d",w,slot,OLED_SRV_SLOTS);
+    close(mfd);             // mapping ของเรายังอยู่ client ได้ fd ของตัวเองไปแล้ว
+    return 0;
+}
+
+static void drop(layer_t *l){
+    if(l->claimed && l->shown>=0){
+        l->shown=-1;
+        damage(l);
+    }
+    if(l->shm) munmap((void*)l->shm,l->slot_size*OLED_SRV_SLOTS);
+    evloop_del(l->fd);
+    close(l->fd);
+    memset(l,0,sizeof(*l));
+    l->fd=-1;
+    l->shown=-1;
+    arm_expiry();
+}
+
+static void command(layer_t *l,char *msg){
+    char cmd[16];
+    int a[6], n;
+    if(sscanf(msg,"%15s%n",cmd,&n)!=1){ reply(l->fd,-1,"err empty"); return; }
+    char *args=msg+n;
+
+    if(strcmp(cmd,"claim")==0){
+        int k=sscanf(args,"%d %d %d %d %d %d",&a[0],&a[1],&a[2],&a[3],&a[4],&a[5]);
+        if(l->claimed){ reply(l->fd,-1,"err claimed"); return; }
+        if(k<4){ reply(l->fd,-1,"err usage: claim x y w h [prio] [timeout_ms]"); return; }
+        l->prio=k>4?a[4]:0;
+        l->timeout_ms=k>5&&a[5]>0?a[5]:0;
+        claim(l,a[0],a[1],a[2],a[3]);
+        return;
+    }
+    if(!l->claimed){ reply(l->fd,-1,"err not claimed"); return; }
+
+    if(strcmp(cmd,"commit")==0){
+        if(sscanf(args,"%d",&a[0])!=1 || a[0]<0 || a[0]>=OLED_SRV_SLOTS){ reply(l->fd,-1,"err slot"); return; }
+        l->shown=a[0];
+        l->until=l->timeout_ms?now_ms()+l->timeout_ms:0;
+        damage(l);
+    }
+    else if(strcmp(cmd,"prio")==0){
+        if(sscanf(args,"%d",&a[0])!=1){ reply(l->fd,-1,"err usage: prio n"); return; }
+        l->prio=a[0];
+        if(l->shown>=0) damage(l);
+    }
+    else if(strcmp(cmd,"timeout")==0){
+        if(sscanf(args,"%d",&a[0])!=1 || a[0]<0){ reply(l->fd,-1,"err usage: timeout ms"); return; }
+        l->timeout_ms=a[0];
+        if(l->shown>=0) l->until=a[0]?now_ms()+a[0]:0;
+    }
+    else if(strcmp(cmd,"hide")==0){
+        if(l->shown>=0){ l->shown=-1; damage(l); }
+    }
+    else{ reply(l->fd,-1,"err unknown command"); return; }
+    arm_expiry();
+    reply(l->fd,-1,"ok");
+}
+
+static void on_client(int fd,uint32_t events,void *ctx){
+    layer_t *l=ctx;
+    char msg[128];
+    for(;;){
+        ssize_t n=recv(fd,msg,sizeof(msg)-1,MSG_DONTWAIT);
+        if(n<0 && (errno==EAGAIN || errno==EWOULDBLOCK)) break;
+        if(n<=0){ drop(l); return; }
+        msg[n]=0;
+        command(l,msg);
+    }
+    if(events&(EPOLLHUP|EPOLLERR)) drop(l);
+}
+
+static void on_accept(int fd,uint32_t events,void *ctx){
+    (void)events; (void)ctx;
+    int c;
+    while((c=accept4(fd,NULL,NULL,SOCK_NONBLOCK|SOCK_CLOEXEC))>=0){
+        layer_t *l=NULL;
+        for(int i=0;i<OLED_SRV_CLIENTS && !l;i++) if(layers[i].fd<0) l=&layers[i];
+        if(!l){ reply(c,-1,"err busy"); close(c); continue; }
+        l->fd=c;
+        if(evloop_add(c,EPOLLIN,on_client,l)<0){ close(c); l->fd=-1; }
+    }
+}
+
+int oled_srv_start(const char *path,oled_t *o){
+    for(int i=0;i<OLED_SRV_CLIENTS;i++){ layers[i].fd=-1; layers[i].shown=-1; }
+    if(!path || !*path) return 0;
+    panel=o;
+
+    struct sockaddr_un a;
+    memset(&a,0,sizeof(a));
+    a.sun_family=AF_UNIX;
+    if(strlen(path)>=sizeof(a.sun_path)){ fprintf(stderr,"oled_srv: socket path too long\n"); return -1; }
+    strcpy(a.sun_path,path);
+
+    if(!(expire_timer=evtimer_new(on_expire,NULL))) return -1;
+    listen_fd=socket(AF_UNIX,SOCK_SEQPACKET|SOCK_NONBLOCK|SOCK_CLOEXEC,0);
+    if(listen_fd<0){ perror("oled_srv socket"); return -1; }
+    unlink(path);
+    if(bind(listen_fd,(struct sockaddr*)&a,sizeof(a))<0 || listen(listen_fd,4)<0){
+        perror("oled_srv bind");
+        close(listen_fd);
+        listen_fd=-1;
+        return -1;
+    }
+    sock_path=strdup(path);
+    scene_set_painter(paint);
+    return evloop_add(listen_fd,EPOLLIN,on_accept,NULL);
+}
+
+void oled_srv_stop(void){
+    if(listen_fd<0) return;
+    scene_set_painter(NULL);
+    for(int i=0;i<OLED_SRV_CLIENTS;i++){
+        layer_t *l=&layers[i];
+        if(l->fd<0) continue;
+        if(l->shm) munmap((void*)l->shm,l->slot_size*OLED_SRV_SLOTS);
+        evloop_del(l->fd);
+        close(l->fd);
+        l->fd=-1;
+    }
+    evloop_del(listen_fd);
+    close(listen_fd);
+    listen_fd=-1;
+    unlink(sock_path);
+    free(sock_path);
+    sock_path=NULL;
+}
@@ -0,0 +1,30 @@
+#ifndef OLED_SRV_H
+#define OLED_SRV_H
+
+#include "oled_i2c.h"
+
+// ให้ process อื่นบนเครื่อง (agent, script deploy) วาดลง OLED ได้โดยไม่ต้องแตะ /dev/i2c-0
+// client ต่อ Unix socket (SOCK_SEQPACKET, DISPLAY_SOCKET ใน .env) ขอ region แล้วได้ memfd กลับมา
+// วาด pixel ลง memfd ตรงๆ (ไม่มีการส่ง pixel ผ่าน socket) แล้วสั่ง commit
+// controller วาด layer ทับข้อความของ scene แล้วส่งทาง oled_display ตามปกติ
+//
+// หนึ่งคำสั่งต่อ message ตอบ "ok ..." หรือ "err <เหตุผล>":
+//   claim <x> <y> <w> <h> [prio] [timeout_ms]  ตอบ "ok <stride> <slot_size> <slots>" พร้อม memfd (SCM_RIGHTS)
+//   commit <slot>      แสดง slot นี้ (slot ที่ commit ล่าสุดห้ามแก้จนกว่าจะ commit slot อื่น)
+//   prio <n>           layer prio สูงอยู่บน (เท่ากัน = claim ทีหลังอยู่บน) ข้อความของ scene อยู่ล่างสุดเสมอ
+//   timeout <ms>       ซ่อน layer ถ้าไม่ commit ใหม่ภายใน ms (0 = แสดงจนกว่าจะปิด)
+//   hide               ซ่อนจนกว่าจะ commit ครั้งถัดไป
+// ปิด socket = คืน region
+//
+// memfd มี OLED_SRV_SLOTS slot ติดกัน slot ละ slot_size byte: layout page แบบ SSD1306
+// (byte ที่ page*stride+x, bit = y%8) ขนาดคงที่ (seal ไว้ client ย่อ/ขยายไม่ได้)
+#define OLED_SRV_SLOTS 2
+#ifndef OLED_SRV_CLIENTS
+#define OLED_SRV_CLIENTS 8
+#endif
+
+// path "" หรือ NULL = ไม่เปิด layer วาดลง o ผ่าน scene (scene_set_painter)
+int oled_srv_start(const char *path,oled_t *o);
+void oled_srv_stop(void);
+
+#endif
@@ -0,0 +1,421 @@
+#define _GNU_SOURCE
+#include "proto.h"
+#include "monitors.h"
+#include "evloop.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/socket.h>
+
+struct inflight {
+    int used;
+    int idx;                // monitor ที่สั่ง (ไว้แจ้งตอนหาย)
+    uint32_t op;            // การส่งแบบกลุ่มที่ frame นี้เป็นส่วนหนึ่ง (0 = ส่งตัวเดียว)
+    uint32_t seq;
+    uint8_t tries;
+    int64_t deadline;
+    uint8_t frame[PROTO_FRAME_LEN];
+};
+
+// ปลายทางหนึ่ง address:port (monitor หลายตัวที่ใช้ address เดียวกันใช้ seq ชุดเดียวกัน)
+struct peer {
+    struct sockaddr_in addr;
+    uint32_t next_seq;
+    struct inflight q[PROTO_WINDOW];    // ช่อง seq % PROTO_WINDOW
+};
+
+// หน้าต่างรวม UP/DOWN ต่อ monitor: การกดครั้งแรกส่งทันที ครั้งที่ตามมาภายในหน้าต่าง
+// สะสมเป็น count แล้วส่งเป็น frame เดียวตอนหน้าต่างปิด
+struct pending {
+    int open;
+    int cmd;
+    int count;
+    int64_t deadline;
+};
+
+// peer ที่ไม่มี monitor ชี้แล้ว (address เปลี่ยนตอน reload config) ยังส่งซ้ำ/รับ ack ของ frame ที่ค้างจนครบ
+// จึงจองไว้มากกว่า MONITOR_MAX ช่องที่ไม่มีใครชี้และไม่มี frame ค้างถูกใช้ซ้ำ
+#define PROTO_PEERS (MONITOR_MAX*2)
+
+static int sock = -1;
+static int nmon;
+static int modes[MONITOR_MAX];
+static int peer_of[MONITOR_MAX];
+static struct peer peers[PROTO_PEERS];
+static int npeers;
+static struct pending pend[MONITOR_MAX];
+static void (*lost_cb)(int idx,int cmd);
+static evtimer_t *timer;
+static proto_stats_t stats;
+
+// การส่งแบบกลุ่ม: datagram ของทุกปลายทางรวมเป็น sendmmsg() เดียว (แบ่งชุดละ PROTO_BATCH)
+#define PROTO_BATCH MONITOR_MAX
+static struct mmsghdr batch[PROTO_BATCH];
+static struct iovec batch_iov[PROTO_BATCH];
+static int batch_peer[PROTO_BATCH];
+static int nbatch;
+static uint8_t batch_failed[PROTO_PEERS];     // ต่อ peer: kernel ไม่รับ datagram ใดของ peer นี้
+
+static uint32_t group_op;                   // id ของการส่งแบบกลุ่มล่าสุด
+static proto_group_status_t group_st;
+static void (*group_cb)(const proto_group_status_t *st);
+
+static int64_t now_ms(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (int64_t)ts.tv_sec*1000+ts.tv_nsec/1000000;
+}
+
+static void put32(uint8_t *p,uint32_t v){ p[0]=v>>24; p[1]=v>>16; p[2]=v>>8; p[3]=v; }
+static uint32_t get32(const uint8_t *p){ return (uint32_t)p[0]<<24|(uint32_t)p[1]<<16|(uint32_t)p[2]<<8|p[3]; }
+
+size_t proto_encode(uint8_t *out,int cmd,int count,uint32_t seq,uint32_t ts){
+    out[0]=PROTO_MAGIC;
+    out[1]=PROTO_VERSION;
+    out[2]=(uint8_t)cmd;
+    out[3]=(uint8_t)count;
+    put32(out+4,seq);
+    put32(out+8,ts);
+    return PROTO_FRAME_LEN;
+}
+
+int proto_decode_ack(const uint8_t *in,size_t len,uint32_t *ack_seq,uint32_t *bitmap,uint32_t *ts){
+    if(len<PROTO_ACK_LEN || in[0]!=PROTO_MAGIC || in[1]!=PROTO_VERSION || in[2]!=PROTO_ACK) return -1;
+    *ack_seq=get32(in+4);
+    *bitmap=get32(in+8);
+    *ts=get32(in+12);
+    return 0;
+}
+
+static void xmit(const struct peer *p,const void *buf,size_t len){
+    uint64_t t0=metrics_now();
+    if(sendto(sock,buf,len,0,(const struct sockaddr*)&p->addr,sizeof(p->addr))<0) perror("Send failed");
+    else metrics_add(M_DATAGRAMS,1);
+    metrics_since(M_SEND,t0);
+}
+
+// ตั้ง timer ให้ตรงกับ deadline ที่ใกล้ที่สุด (รวม/ส่งซ้ำ)
+static void rearm(void){
+    int64_t next=-1;
+    for(int i=0;i<nmon;i++)
+        if(pend[i].open && (next<0 || pend[i].deadline<next)) next=pend[i].deadline;
+    for(int k=0;k<npeers;k++)
+        for(int j=0;j<PROTO_WINDOW;j++){
+            const struct inflight *f=&peers[k].q[j];
+            if(f->used && (next<0 || f->deadline<next)) next=f->deadline;
+        }
+    if(next<0){ if(evtimer_armed(timer)) evtimer_disarm(timer); return; }
+    int64_t ms=next-now_ms();
+    evtimer_arm(timer,ms>0?(int)ms:1,0);
+}
+
+static void group_update(struct inflight *f,int acked){
+    if(!f->op || f->op!=group_op) return;
+    if(acked) group_st.acked++;
+    else group_st.lost++;
+    if(group_cb) group_cb(&group_st);
+}
+
+static void lose(struct inflight *f){
+    f->used=0;
+    stats.lost++;
+    group_update(f,0);
+    if(lost_cb && f->idx>=0) lost_cb(f->idx,f->frame[2]);
+}
+
+// จองช่อง seq ถัดไปของ peer แล้วเข้ารหัส frame ไว้ในช่องนั้น (ยังไม่ส่ง)
+static struct inflight *new_frame(int idx,int cmd,int count){
+    struct peer *p=&peers[peer_of[idx]];
+    uint32_t seq=p->next_seq++;
+    struct inflight *f=&p->q[seq%PROTO_WINDOW];
+    if(f->used) lose(f);                // ค้างมาครบหน้าต่างแล้ว ถือว่าหาย
+
+    int64_t now=now_ms();
+    f->used=1;
+    f->idx=idx;
+    f->op=0;
+    f->seq=seq;
+    f->tries=1;
+    f->deadline=now+PROTO_RTO_MS;
+    proto_encode(f->frame,cmd,count,seq,(uint32_t)now);
+    stats.frames++;
+    return f;
+}
+
+static void send_binary(int idx,int cmd,int count){
+    struct inflight *f=new_frame(idx,cmd,count);
+    xmit(&peers[peer_of[idx]],f->frame,PROTO_FRAME_LEN);
+}
+
+// ข้อความของคำสั่งแบบ ASCII คืนจำนวนครั้งที่ต้องส่ง
+// monitor รุ่นเก่ารู้จักแค่ครั้งละหนึ่ง จึงส่งตามจำนวนที่รวมไว้ (ยกเว้น SELECT ที่ count คือเลขจอ)
+static int ascii_text(char *msg,size_t len,int cmd,int count){
+    static const char *text[] = { [PROTO_DO]="do", [PROTO_UP]="up", [PROTO_DOWN]="down", [PROTO_DONE]="done" };
+    if(cmd==PROTO_SELECT){
+        snprintf(msg,len,"m%d",count);
+        return 1;
+    }
+    snprintf(msg,len,"%s",text[cmd]);
+    return count;
+}
+
+static void send_ascii(int idx,int cmd,int count){
+    char msg[8];
+    struct peer *p=&peers[peer_of[idx]];
+
+    count=ascii_text(msg,sizeof(msg),cmd,count);
+    for(int i=0;i<count;i++) xmit(p,msg,strlen(msg));
+    stats.frames+=count;
+}
+
+static void send_now(int idx,int cmd,int count){
+    if(modes[idx]==PROTO_BINARY) send_binary(idx,cmd,count);
+    else send_ascii(idx,cmd,count);
+}
+
+// ส่งที่สะสมไว้ คืน 1 ถ้ามีอะไรถูกส่ง
+static int flush_pending(int idx){
+    struct pending *q=&pend[idx];
+    if(!q->count) return 0;
+    send_now(idx,q->cmd,q->count);
+    q->count=0;
+    return 1;
+}
+
+void proto_send(int idx,int cmd,int count){
+    if(idx<0 || idx>=nmon || count<=0) return;
+    struct pending *q=&pend[idx];
+    int64_t now=now_ms();
+
+    if((cmd==PROTO_UP || cmd==PROTO_DOWN) && q->open && q->cmd==cmd && now<q->deadline && q->count+count<=255){
+        if(q->count) stats.coalesced++;
+        q->count+=count;
+        return;
+    }
+
+    flush_pending(idx);
+    q->open=0;
+    send_now(idx,cmd,count);
+    if(cmd==PROTO_UP || cmd==PROTO_DOWN){
+        q->open=1;
+        q->cmd=cmd;
+        q->deadline=now+PROTO_COALESCE_MS;
+    }
+    rearm();
+}
+
+// ส่ง batch ที่สะสมไว้ ถ้า datagram ไหน kernel ไม่รับ sendmmsg จะหยุดตรงนั้น ข้ามตัวนั้นแล้วส่งต่อ
+static void batch_flush(void){
+    int off=0;
+    while(off<nbatch){
+        uint64_t t0=metrics_now();
+        int r=sendmmsg(sock,batch+off,nbatch-off,0);
+        metrics_since(M_SEND,t0);
+        if(r<0){
+            perror("sendmmsg");
+            batch_failed[batch_peer[off]]=1;
+            off++;
+        } else {
+            metrics_add(M_DATAGRAMS,r);
+            off+=r;
+        }
+    }
+    nbatch=0;
+}
+
+static void batch_add(int k,const void *buf,size_t len){
+    if(nbatch==PROTO_BATCH) batch_flush();
+    struct mmsghdr *m=&batch[nbatch];
+    batch_iov[nbatch].iov_base=(void*)buf;
+    batch_iov[nbatch].iov_len=len;
+    memset(m,0,sizeof(*m));
+    m->msg_hdr.msg_name=&peers[k].addr;
+    m->msg_hdr.msg_namelen=sizeof(peers[k].addr);
+    m->msg_hdr.msg_iov=&batch_iov[nbatch];
+    m->msg_hdr.msg_iovlen=1;
+    batch_peer[nbatch++]=k;
+}
+
+int proto_send_group(const int *members,int n,int cmd,int count,void (*on_update)(const proto_group_status_t *st)){
+    uint8_t seen[PROTO_PEERS]={0};
+    char msg[8];
+    int reps=ascii_text(msg,sizeof(msg),cmd,count);
+    size_t len=strlen(msg);
+
+    if(++group_op==0) group_op=1;
+    memset(&group_st,0,sizeof(group_st));
+    group_cb=on_update;
+    memset(batch_failed,0,sizeof(batch_failed));
+
+    for(int j=0;j<n;j++){
+        int idx=members[j];
+        if(idx<0 || idx>=nmon) continue;
+        // UP/DOWN ที่ยังรวมอยู่ของตัวนี้ออกไปก่อนเพื่อรักษาลำดับ
+        flush_pending(idx);
+        pend[idx].open=0;
+
+        // monitor ที่ใช้ address เดียวกันได้ datagram เดียว
+        int k=peer_of[idx];
+        if(seen[k]) continue;
+        seen[k]=1;
+        group_st.targets++;
+
+        if(modes[idx]==PROTO_BINARY){
+            struct inflight *f=new_frame(idx,cmd,count);
+            f->op=group_op;
+            group_st.binary++;
+            batch_add(k,f->frame,PROTO_FRAME_LEN);
+        } else {
+            for(int r=0;r<reps;r++) batch_add(k,msg,len);
+            stats.frames+=reps;
+        }
+    }
+    batch_flush();
+
+    for(int k=0;k<npeers;k++)
+        if(seen[k] && !batch_failed[k]) group_st.sent++;
+    rearm();
+    if(group_cb) group_cb(&group_st);
+    return group_st.sent;
+}
+
+static void on_timer(void *ctx){
+    (void)ctx;
+    int64_t now=now_ms();
+    for(int i=0;i<nmon;i++){
+        struct pending *q=&pend[i];
+        if(!q->open || q->deadline>now) continue;
+        // ยังกดซ้ำอยู่: เปิดหน้าต่างต่อ, ไม่มีอะไรเข้ามาแล้ว: ปิด
+        if(flush_pending(i)) q->deadline=now+PROTO_COALESCE_MS;
+        else q->open=0;
+    }
+
+    for(int k=0;k<npeers;k++){
+        struct peer *p=&peers[k];
+        for(int j=0;j<PROTO_WINDOW;j++){
+            struct inflight *f=&p->q[j];
+            if(!f->used || f->deadline>now) continue;
+            if(f->tries>PROTO_RETRIES){ lose(f); continue; }
+            f->deadline=now+((int64_t)PROTO_RTO_MS<<f->tries);
+            f->tries++;
+            xmit(p,f->frame,PROTO_FRAME_LEN);
+            stats.retransmits++;
+        }
+    }
+    rearm();
+}
+
+int proto_input(const void *buf,size_t len,const struct sockaddr_in *from){
+    uint32_t ack_seq,bitmap,ts;
+    if(proto_decode_ack(buf,len,&ack_seq,&bitmap,&ts)<0) return -1;
+
+    struct peer *p=NULL;
+    for(int k=0;k<npeers;k++)
+        if(peers[k].addr.sin_addr.s_addr==from->sin_addr.s_addr && peers[k].addr.sin_port==from->sin_port) p=&peers[k];
+    if(!p) return -1;
+
+    for(int j=0;j<PROTO_WINDOW;j++){
+        struct inflight *f=&p->q[j];
+        if(!f->used) continue;
+        int32_t d=(int32_t)(f->seq-ack_seq);
+        if(d<=0 || (d<=32 && (bitmap>>(d-1)&1))){
+            f->used=0;
+            stats.acked++;
+            group_update(f,1);
+        }
+    }
+    stats.last_rtt_ms=(uint32_t)now_ms()-ts;
+    rearm();
+    return 0;
+}
+
+void proto_get_stats(proto_stats_t *st){ *st=stats; }
+
+static int peer_referenced(int k,int except){
+    for(int i=0;i<nmon;i++) if(i!=except && peer_of[i]==k) return 1;
+    return 0;
+}
+
+static int peer_idle(const struct peer *p){
+    for(int j=0;j<PROTO_WINDOW;j++) if(p->q[j].used) return 0;
+    return 1;
+}
+
+// ช่องสำหรับ peer ใหม่: ต่อท้าย หรือใช้ช่องที่ไม่มีใครชี้และไม่มี frame ค้าง
+// เต็มจริงๆ (frame ค้างทุกช่อง) ใช้ช่องที่ไม่มีใครชี้ แล้วนับ frame ที่ค้างเป็นหาย
+static int new_peer(int idx){
+    int spare=-1;
+    for(int k=0;k<npeers;k++){
+        if(peer_referenced(k,idx)) continue;
+        if(peer_idle(&peers[k])) return k;
+        if(spare<0) spare=k;
+    }
+    if(npeers<PROTO_PEERS) return npeers++;
+    for(int j=0;j<PROTO_WINDOW;j++) if(peers[spare].q[j].used) lose(&peers[spare].q[j]);
+    return spare;
+}
+
+// monitor ที่ address:port ซ้ำกับตัวที่มีอยู่ใช้ peer (และ seq) ร่วมกัน
+static void attach(int idx,const struct sockaddr_in *addr,int mode){
+    int k;
+    for(k=0;k<npeers;k++)
+        if(peers[k].addr.sin_addr.s_addr==addr->sin_addr.s_addr && peers[k].addr.sin_port==addr->sin_port) break;
+    if(k==npeers){
+        k=new_peer(idx);
+        memset(&peers[k],0,sizeof(peers[k]));
+        peers[k].addr=*addr;
+        peers[k].next_seq=1;
+    }
+    peer_of[idx]=k;
+    modes[idx]=mode;
+    memset(&pend[idx],0,sizeof(pend[idx]));
+}
+
+int proto_add(const struct sockaddr_in *addr,int mode){
+    if(nmon>=MONITOR_MAX) return -1;
+    attach(nmon,addr,mode);
+    return nmon++;
+}
+
+// monitor idx เลิกใช้ peer เดิม: UP/DOWN ที่รวมไว้ส่งไป address เดิมก่อน frame ที่รอ ack ส่งซ้ำต่อจนครบ
+// แต่ถ้าหายจะไม่แจ้งว่าเป็นของ idx (ช่องนั้นเป็น monitor อื่นไปแล้ว)
+static void detach(int idx){
+    struct peer *p=&peers[peer_of[idx]];
+    flush_pending(idx);
+    pend[idx].open=0;
+    for(int j=0;j<PROTO_WINDOW;j++)
+        if(p->q[j].used && p->q[j].idx==idx) p->q[j].idx=-1;
+}
+
+int proto_update(const struct sockaddr_in *addrs,const int *m,int n){
+    if(n<0 || n>MONITOR_MAX) return -1;
+    for(int i=n;i<nmon;i++) detach(i);
+    if(nmon>n) nmon=n;
+    for(int i=0;i<n;i++){
+        if(i<nmon){
+            const struct sockaddr_in *a=&peers[peer_of[i]].addr;
+            if(a->sin_addr.s_addr==addrs[i].sin_addr.s_addr && a->sin_port==addrs[i].sin_port){
+                if(modes[i]!=m[i]){ flush_pending(i); pend[i].open=0; modes[i]=m[i]; }
+                continue;
+            }
+            detach(i);
+        }
+        attach(i,&addrs[i],m[i]);
+        if(i>=nmon) nmon=i+1;
+    }
+    rearm();
+    return 0;
+}
+
+int proto_init(int s,const struct sockaddr_in *addrs,const int *m,int n,void (*on_lost)(int idx,int cmd)){
+    if(n<0 || n>MONITOR_MAX) return -1;
+    sock=s;
+    lost_cb=on_lost;
+
+    npeers=0;
+    for(nmon=0;nmon<n;nmon++) attach(nmon,&addrs[nmon],m[nmon]);
+
+    timer=evtimer_new(on_timer,NULL);
+    return timer?0:-1;
+}
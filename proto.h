@@ -0,0 +1,91 @@
+#ifndef PROTO_H
+#define PROTO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <netinet/in.h>
+
+// คำสั่งไป monitor แบบ binary (version 1) ตัวเลขหลายไบต์เป็น big-endian
+//
+//   frame คำสั่ง 12 byte (controller -> monitor)
+//     0  magic 0xA5
+//     1  version
+//     2  cmd (PROTO_DO ...)
+//     3  count: จำนวนครั้งของ UP/DOWN ที่รวมมา, เลข monitor ของ PROTO_SELECT, อื่นๆ = 1
+//     4  seq (u32) เพิ่มทีละ 1 ต่อปลายทาง
+//     8  timestamp (u32, ms ของ controller)
+//
+//   ack 16 byte (monitor -> controller)
+//     0  magic, 1 version, 2 PROTO_ACK, 3 0
+//     4  ack_seq (u32): ได้รับครบทุก seq จนถึงเลขนี้
+//     8  bitmap (u32): bit k = ได้รับ ack_seq+1+k แล้ว (selective ack)
+//    12  timestamp ที่สะท้อนกลับจาก frame ล่าสุด
+//
+// monitor ที่ยังไม่อัปเกรดใช้แบบ ASCII เดิม ("do", "up", "m1" ...) ไม่มี seq/ack
+#define PROTO_MAGIC     0xA5
+#define PROTO_VERSION   1
+#define PROTO_FRAME_LEN 12
+#define PROTO_ACK_LEN   16
+
+#ifndef PROTO_COALESCE_MS
+#define PROTO_COALESCE_MS 40    // UP/DOWN ที่ซ้ำภายในช่วงนี้รวมเป็น datagram เดียว
+#endif
+#ifndef PROTO_RTO_MS
+#define PROTO_RTO_MS 60         // ไม่มี ack ภายในเวลานี้ส่งซ้ำ (เท่าตัวทุกครั้ง)
+#endif
+#ifndef PROTO_RETRIES
+#define PROTO_RETRIES 3
+#endif
+#define PROTO_WINDOW 32         // frame ที่รอ ack ได้พร้อมกันต่อปลายทาง (เท่ากับ bitmap)
+
+enum { PROTO_DO=1, PROTO_UP, PROTO_DOWN, PROTO_DONE, PROTO_SELECT, PROTO_ACK=0x80 };
+enum { PROTO_ASCII, PROTO_BINARY };
+
+typedef struct {
+    uint32_t frames;        // datagram คำสั่งที่ส่ง (ไม่นับส่งซ้ำ)
+    uint32_t coalesced;     // การกดซ้ำที่ถูกรวมเข้า frame อื่น
+    uint32_t retransmits;
+    uint32_t acked;
+    uint32_t lost;          // ส่งซ้ำครบแล้วยังไม่มี ack
+    uint32_t last_rtt_ms;
+} proto_stats_t;
+
+// ผลของการส่งแบบกลุ่มล่าสุด (นับต่อปลายทาง monitor ที่ใช้ address เดียวกันนับเป็นหนึ่ง)
+typedef struct {
+    int targets;            // ปลายทางทั้งหมด
+    int sent;               // kernel รับ datagram ไปแล้ว
+    int binary;             // ปลายทางแบบ binary ที่รอ ack ได้
+    int acked;
+    int lost;               // ส่งซ้ำครบแล้วไม่มี ack
+} proto_group_status_t;
+
+// sock = socket ที่ใช้ส่งคำสั่ง (ack กลับมาที่ socket นี้ ให้ส่งต่อเข้า proto_input)
+// modes[i] = PROTO_ASCII / PROTO_BINARY ของ monitor i
+// on_lost(idx,cmd) ถูกเรียกเมื่อคำสั่งหายหลังส่งซ้ำครบ
+int proto_init(int sock,const struct sockaddr_in *addrs,const int *modes,int n,void (*on_lost)(int idx,int cmd));
+
+// เพิ่ม monitor ระหว่างทำงาน คืน index หรือ -1 ถ้าเต็ม
+int proto_add(const struct sockaddr_in *addr,int mode);
+
+// แทนรายการทั้งหมด (config ใหม่): monitor ที่ address เดิมใช้ seq ต่อจากเดิม
+// ที่เปลี่ยน address ส่งที่รวมไว้ไป address เดิมก่อน และ frame ที่รอ ack ยังส่งซ้ำไป address เดิมจนครบ
+int proto_update(const struct sockaddr_in *addrs,const int *modes,int n);
+
+// ส่งคำสั่งไป monitor idx: UP/DOWN รอรวมกับการกดซ้ำภายใน PROTO_COALESCE_MS
+// คำสั่งอื่นส่งทันที (ส่ง UP/DOWN ที่รออยู่ออกไปก่อนเพื่อรักษาลำดับ)
+void proto_send(int idx,int cmd,int count);
+
+// ส่งคำสั่งไปทุก monitor ใน members ทันทีด้วย sendmmsg() ครั้งเดียว (ไม่รอรวม UP/DOWN)
+// on_update ถูกเรียกหลังส่งและทุกครั้งที่ ack/หาย ของการส่งครั้งนี้เปลี่ยน จนกว่าจะส่งแบบกลุ่มครั้งถัดไป
+// คืนจำนวนปลายทางที่ส่งออกได้
+int proto_send_group(const int *members,int n,int cmd,int count,void (*on_update)(const proto_group_status_t *st));
+
+// datagram ที่เข้ามาทาง sock: คืน 0 ถ้าเป็น ack ที่รู้จัก
+int proto_input(const void *buf,size_t len,const struct sockaddr_in *from);
+
+void proto_get_stats(proto_stats_t *st);
+
+size_t proto_encode(uint8_t *out,int cmd,int count,uint32_t seq,uint32_t ts);
+int proto_decode_ack(const uint8_t *in,size_t len,uint32_t *ack_seq,uint32_t *bitmap,uint32_t *ts);
+
+#endif
@@ -0,0 +1,262 @@
+#include "scene.h"
+#include "oled_i2c.h"
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+// ข้อความยาวกว่า region เลื่อนซ้ายทีละ MARQUEE_STEP_PX ทุก MARQUEE_STEP_MS
+// หยุดค้างที่ต้นข้อความ MARQUEE_HOLD_MS ทุกรอบ เว้นช่อง MARQUEE_GAP ก่อนข้อความวนกลับมา
+// ครบ MARQUEE_PASSES รอบแล้วหยุดที่ต้นข้อความ (timer ว่าง ไม่ต้องตื่นอีก)
+// ทุก step ทุก column ในแถบเปลี่ยน: ส่งแถบ page ที่มีหมึกทั้งแถบ (18 px = 3 page ~ 400 byte ต่อ step)
+#ifndef MARQUEE_STEP_PX
+#define MARQUEE_STEP_PX 2
+#endif
+#ifndef MARQUEE_STEP_MS
+#define MARQUEE_STEP_MS 100
+#endif
+#ifndef MARQUEE_PASSES
+#define MARQUEE_PASSES 2
+#endif
+#ifndef MARQUEE_HOLD_MS
+#define MARQUEE_HOLD_MS 1500
+#endif
+#ifndef MARQUEE_GAP
+#define MARQUEE_GAP 32
+#endif
+
+typedef struct {
+    int x, y, w, h;         // สี่เหลี่ยมที่ region วาดได้ (วาดใหม่/ล้างเฉพาะตรงนี้)
+    int baseline;           // y ของ baseline ข้อความ
+    char text[SCENE_TEXT_MAX];
+    int size;
+    char overlay[SCENE_TEXT_MAX];
+    int overlay_size;
+    int64_t overlay_until;  // ms (CLOCK_MONOTONIC), 0 = ไม่มี overlay
+    // ข้อความที่แสดงกว้างกว่า region (marquee): render ลง strip นอกจอครั้งเดียว แล้วเลื่อนเฉพาะ page ที่มีหมึก
+    oled_t *strip;          // NULL = ข้อความพอดี region
+    int loop;               // ความกว้างข้อความ + MARQUEE_GAP (ระยะวนซ้ำ)
+    int page0, page1;       // page ที่ข้อความมีหมึก (พิกัดเดียวกับจอ)
+    int offset;             // column ของข้อความที่อยู่ขอบซ้าย region
+    int passes;             // เลื่อนครบไปกี่รอบแล้ว
+    int64_t next_step;      // ms, 0 = หยุดแล้ว (ครบ MARQUEE_PASSES)
+} region_t;
+
+// สี่เหลี่ยมของสอง region ซ้อนกันเล็กน้อย เพราะสระ/วรรณยุกต์ไทยยื่นเกิน baseline/ascent
+// ตอนวาดใหม่จึงวาด region ข้างเคียงที่คร่อมอยู่ด้วย (clip อยู่ในสี่เหลี่ยมที่วาดใหม่)
+static region_t regions[SCENE_REGIONS]={
+    [SCENE_HEADER]={ .x=0, .y=0,  .w=128, .h=36, .baseline=30 },
+    [SCENE_STATUS]={ .x=0, .y=28, .w=128, .h=36, .baseline=60 },
+};
+
+static oled_t *oled;        // จอที่ scene วาดลง
+static int paused;
+static void (*painter)(oled_t *o);     // วาดทับทุก region (layer ของ oled_srv.c)
+
+static int64_t now_ms(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (int64_t)ts.tv_sec*1000+ts.tv_nsec/1000000;
+}
+
+static const char *shown_text(const region_t *r,int *size){
+    if(r->overlay_until){ *size=r->overlay_size; return r->overlay; }
+    *size=r->size;
+    return r->text;
+}
+
+static int overlaps(const region_t *a,const region_t *b){
+    return a->x<b->x+b->w && b->x<a->x+a->w && a->y<b->y+b->h && b->y<a->y+a->h;
+}
+
+// ข้อความที่แสดงเปลี่ยน: กว้างเกิน region -> render strip ใหม่ (FreeType/cache ครั้งเดียว ตอนเลื่อนแค่ blit)
+static void update_marquee(region_t *r){
+    int size;
+    const char *t=shown_text(r,&size);
+    int w=*t ? render_text_width(t,size) : 0;
+    oled_close(r->strip);
+    r->strip=NULL;
+    if(w<=r->w) return;
+
+    if(w+MARQUEE_GAP>OLED_CANVAS_MAX_WIDTH) w=OLED_CANVAS_MAX_WIDTH-MARQUEE_GAP;
+    if(!(r->strip=oled_canvas(w+MARQUEE_GAP,oled_height(oled)))) return;
+    render_text(r->strip,t,0,r->baseline,size);
+
+    const uint8_t *bits=oled_bits(r->strip);
+    int pages=oled_height(oled)/8, stride=oled_width(r->strip);
+    r->page0=pages; r->page1=-1;
+    for(int p=0;p<pages;p++){
+        for(int x=0;x<stride;x++){
+            if(!bits[p*stride+x]) continue;
+            if(p<r->page0) r->page0=p;
+            r->page1=p;
+            break;
+        }
+    }
+    if(r->page1<0){ oled_close(r->strip); r->strip=NULL; return; }   // ไม่มีหมึก (ไม่มี glyph ในฟอนต์)
+    r->loop=stride;
+    r->offset=0;
+    r->passes=0;
+    r->next_step=now_ms()+MARQUEE_HOLD_MS;
+}
+
+// วาด strip ที่ตำแหน่งปัจจุบัน (ต่อท้ายด้วยต้นข้อความเมื่อวนมาถึง) เฉพาะ page ที่มีหมึก
+static void draw_marquee(const region_t *r){
+    const uint8_t *bits=oled_bits(r->strip)+r->page0*r->loop;
+    int h=(r->page1-r->page0+1)*8;
+    for(int x=r->x-r->offset;x<r->x+r->w;x+=r->loop)
+        oled_blit(oled,x,r->page0*8,bits,r->loop,h);
+}
+
+// ล้างสี่เหลี่ยมของ region แล้ววาดทุก region ที่คร่อมสี่เหลี่ยมนี้ใหม่ (clip ไว้)
+static void repaint(const region_t *damage){
+    oled_set_clip(oled,damage->x,damage->y,damage->w,damage->h);
+    oled_fill_rect(oled,damage->x,damage->y,damage->w,damage->h,0);
+    for(int i=0;i<SCENE_REGIONS;i++){
+        const region_t *r=&regions[i];
+        if(!overlaps(r,damage)) continue;
+        int size;
+        const char *t=shown_text(r,&size);
+        if(r->strip) draw_marquee(r);
+        else if(*t) render_text(oled,t,r->x,r->baseline,size);
+    }
+    if(painter) painter(oled);
+    oled_reset_clip(oled);
+}
+
+static void copy_text(char *dst,const char *src){
+    strncpy(dst,src,SCENE_TEXT_MAX-1);
+    dst[SCENE_TEXT_MAX-1]=0;
+}
+
+void scene_init(oled_t *o){
+    oled=o;
+    for(int i=0;i<SCENE_REGIONS;i++){
+        regions[i].text[0]=0;
+        regions[i].overlay_until=0;
+    }
+    scene_redraw();
+}
+
+void scene_set_text(scene_region_t id,const char *text,int font_size){
+    region_t *r=&regions[id];
+    if(r->size==font_size && strncmp(r->text,text,SCENE_TEXT_MAX-1)==0) return;
+
+    copy_text(r->text,text);
+    r->size=font_size;
+    if(r->overlay_until || paused) return;  // overlay ยังบังอยู่ จะเห็นตอนหมดเวลา
+
+    update_marquee(r);
+    repaint(r);
+    oled_display(oled);
+}
+
+void scene_overlay(scene_region_t id,const char *text,int font_size,int ms){
+    region_t *r=&regions[id];
+    int changed=!r->overlay_until || r->overlay_size!=font_size
+                || strncmp(r->overlay,text,SCENE_TEXT_MAX-1)!=0;
+
+    copy_text(r->overlay,text);
+    r->overlay_size=font_size;
+    r->overlay_until=now_ms()+ms;
+    if(!changed || paused) return;
+
+    update_marquee(r);
+    repaint(r);
+    oled_display(oled);
+}
+
+// ปลด overlay คืน 1 ถ้าต้องวาดใหม่
+static int drop_overlay(region_t *r){
+    r->overlay_until=0;
+    // overlay เหมือนข้อความหลักอยู่แล้ว ไม่ต้องวาดใหม่
+    if(paused || (r->overlay_size==r->size && strcmp(r->overlay,r->text)==0)) return 0;
+    update_marquee(r);
+    repaint(r);
+    return 1;
+}
+
+void scene_cancel_overlay(scene_region_t id){
+    region_t *r=&regions[id];
+    if(r->overlay_until && drop_overlay(r)) oled_display(oled);
+}
+
+void scene_tick(void){
+    int64_t now=now_ms();
+    int changed=0;
+    for(int i=0;i<SCENE_REGIONS;i++){
+        region_t *r=&regions[i];
+        if(!r->overlay_until || now<r->overlay_until) continue;
+        changed|=drop_overlay(r);
+    }
+    if(paused){ if(changed) oled_display(oled); return; }
+
+    // เลื่อน marquee: วาดใหม่เฉพาะแถบ page ที่มีหมึก
+    for(int i=0;i<SCENE_REGIONS;i++){
+        region_t *r=&regions[i];
+        if(!r->strip || !r->next_step || now<r->next_step) continue;
+        r->offset+=MARQUEE_STEP_PX;
+        if(r->offset>=r->loop){
+            r->offset=0;
+            r->next_step=++r->passes<MARQUEE_PASSES ? now+MARQUEE_HOLD_MS : 0;
+        }
+        else r->next_step=now+MARQUEE_STEP_MS;
+        region_t band={ .x=r->x, .y=r->page0*8, .w=r->w, .h=(r->page1-r->page0+1)*8 };
+        repaint(&band);
+        changed=1;
+    }
+    if(changed) oled_display(oled);
+}
+
+int scene_next_expiry_ms(void){
+    int64_t now=now_ms(), next=-1;
+    for(int i=0;i<SCENE_REGIONS;i++){
+        if(!regions[i].overlay_until) continue;
+        int64_t left=regions[i].overlay_until-now;
+        if(left<0) left=0;
+        if(next<0 || left<next) next=left;
+    }
+    return (int)next;
+}
+
+int scene_next_step_ms(void){
+    int64_t now=now_ms(), next=-1;
+    if(paused) return -1;
+    for(int i=0;i<SCENE_REGIONS;i++){
+        if(!regions[i].strip || !regions[i].next_step) continue;
+        int64_t left=regions[i].next_step-now;
+        if(left<0) left=0;
+        if(next<0 || left<next) next=left;
+    }
+    return (int)next;
+}
+
+void scene_redraw(void){
+    if(paused) return;
+    oled_clear(oled);
+    for(int i=0;i<SCENE_REGIONS;i++){
+        region_t *r=&regions[i];
+        int size;
+        const char *t=shown_text(r,&size);
+        update_marquee(r);
+        if(r->strip) draw_marquee(r);
+        else if(*t) render_text(oled,t,r->x,r->baseline,size);
+    }
+    if(painter) painter(oled);
+    oled_display(oled);
+}
+
+void scene_set_painter(void (*fn)(oled_t *o)){ painter=fn; }
+
+void scene_damage(int x,int y,int w,int h){
+    if(paused) return;
+    region_t d={ .x=x, .y=y, .w=w, .h=h };
+    repaint(&d);
+    oled_display(oled);
+}
+
+void scene_pause(void){ paused=1; }
+
+void scene_resume(void){
+    paused=0;
+    scene_redraw();
+}
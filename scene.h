@@ -0,0 +1,49 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "oled_i2c.h"
+
+// หน้าจอแบบ retained: แบ่งเป็น region ข้อความที่มีชื่อ
+// เปลี่ยนข้อความ region ไหนก็วาดใหม่เฉพาะสี่เหลี่ยมของ region นั้น
+typedef enum {
+    SCENE_HEADER,           // บรรทัดบน เช่น "หน้าจอ: 1"
+    SCENE_STATUS,           // บรรทัดล่าง เช่น "เชื่อมต่อ"
+    SCENE_REGIONS
+} scene_region_t;
+
+#define SCENE_TEXT_MAX 96
+
+// region จัดไว้สำหรับจอ 128x64
+void scene_init(oled_t *o);
+
+// ตั้งข้อความหลักของ region ถ้าเหมือนเดิม (ข้อความ+ขนาด) จะไม่ทำอะไรเลย
+void scene_set_text(scene_region_t r,const char *text,int font_size);
+
+// แสดงข้อความชั่วคราวทับ region นาน ms มิลลิวินาที แล้วกลับไปเป็นข้อความหลักเอง
+void scene_overlay(scene_region_t r,const char *text,int font_size,int ms);
+
+// ยกเลิก overlay ทันที (กลับไปแสดงข้อความหลัก)
+void scene_cancel_overlay(scene_region_t r);
+
+// เรียกเป็นระยะ: ปลด overlay ที่หมดเวลา และเลื่อนข้อความที่ยาวเกิน region (marquee)
+void scene_tick(void);
+
+// มิลลิวินาทีจนถึง overlay ถัดไปหมดเวลา (-1 = ไม่มี)
+int scene_next_expiry_ms(void);
+// มิลลิวินาทีจนถึง marquee เลื่อนครั้งถัดไป (-1 = ไม่มีข้อความที่ต้องเลื่อน หรือเลื่อนครบรอบแล้ว)
+int scene_next_step_ms(void);
+
+// วาดทุก region ใหม่ทั้งจอ
+void scene_redraw(void);
+
+// fn ถูกเรียกหลังวาด region ทุกครั้ง (clip อยู่ในสี่เหลี่ยมที่วาดใหม่) ใช้วาดของที่ต้องอยู่บนสุด
+void scene_set_painter(void (*fn)(oled_t *o));
+// วาดสี่เหลี่ยมนี้ใหม่ (region ที่คร่อม + painter) เช่นเมื่อของที่ painter วาดเปลี่ยน
+void scene_damage(int x,int y,int w,int h);
+
+// ระหว่างเริ่มโปรแกรม (ฟอนต์ยังโหลดไม่เสร็จ): เก็บข้อความ/overlay ไว้อย่างเดียว ไม่แตะจอ
+// scene_resume วาดทั้งจอจากสถานะล่าสุด แล้วกลับมาวาดทันทีตามปกติ
+void scene_pause(void);
+void scene_resume(void);
+
+#endif
@@ -0,0 +1,163 @@
+#define _GNU_SOURCE
+#include "status_rx.h"
+#include "health.h"
+#include "evloop.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+#define STATUS_BATCH 16         // datagram ต่อหนึ่ง recvmmsg()
+#define STATUS_DGRAM_MAX 128
+
+_Static_assert(MONITOR_MAX<=64,"changed bitmap in on_readable is 64 bits");
+
+static int sock = -1;
+static struct sockaddr_in monitors[MONITOR_MAX];
+static monitor_status_t status[MONITOR_MAX];
+static int nmonitors;
+static void (*change_cb)(int idx);
+
+// buffer ของ batch ใช้ซ้ำทุกครั้ง
+static char bufs[STATUS_BATCH][STATUS_DGRAM_MAX];
+static struct sockaddr_in froms[STATUS_BATCH];
+static struct iovec iovs[STATUS_BATCH];
+static struct mmsghdr msgs[STATUS_BATCH];
+
+// หา monitor จาก IP ผู้ส่ง (port ไม่สน monitor อาจส่งจาก port ไหนก็ได้)
+static int find_monitor(const struct sockaddr_in *from,char **p){
+    char *s=*p;
+    if(s[0]=='m' && s[1]>='1' && s[1]<='9'){
+        char *end;
+        long id=strtol(s+1,&end,10);
+        if(*end==' ' && id>=1 && id<=nmonitors){
+            if(monitors[id-1].sin_addr.s_addr!=from->sin_addr.s_addr) return -1;
+            *p=end+1;
+            return (int)id-1;
+        }
+    }
+    for(int i=0;i<nmonitors;i++)
+        if(monitors[i].sin_addr.s_addr==from->sin_addr.s_addr) return i;
+    return -1;
+}
+
+// คืน index ของ monitor ถ้าสถานะเปลี่ยน ไม่เช่นนั้น -1
+static int handle(const struct sockaddr_in *from,char *msg){
+    int i=find_monitor(from,&msg);
+    if(i<0) return -1;
+
+    if(strncmp(msg,"hb",2)==0 && (msg[2]==0 || msg[2]==' ')){
+        int lease=msg[2] ? atoi(msg+3) : 0;
+        if(lease<100 || lease>60000) lease=STATUS_LEASE_MS;
+        health_heartbeat(i,lease);
+        return -1;
+    }
+    if(strncmp(msg,"st ",3)==0){
+        char *end;
+        long code=strtol(msg+3,&end,10);
+        if(end==msg+3 || (*end && *end!=' ')) return -1;
+        const char *text=*end ? end+1 : "";
+
+        health_heartbeat(i,STATUS_LEASE_MS);   // ส่งสถานะมาได้ก็แปลว่ายังอยู่
+        monitor_status_t *st=&status[i];
+        if(st->code==code && strncmp(st->text,text,sizeof(st->text)-1)==0) return -1;
+        st->code=(int)code;
+        size_t len=strlen(text);
+        if(len>=sizeof(st->text)){
+            len=sizeof(st->text)-1;
+            while(len>0 && ((unsigned char)text[len]&0xC0)==0x80) len--;   // ไม่ตัดกลางตัวอักษร UTF-8
+        }
+        memcpy(st->text,text,len);
+        st->text[len]=0;
+        return i;
+    }
+    return -1;
+}
+
+static void on_readable(int fd,uint32_t events,void *ctx){
+    (void)events; (void)ctx;
+    uint64_t changed=0;
+    for(;;){
+        for(int k=0;k<STATUS_BATCH;k++){
+            iovs[k].iov_base=bufs[k];
+            iovs[k].iov_len=STATUS_DGRAM_MAX-1;
+            memset(&msgs[k].msg_hdr,0,sizeof(msgs[k].msg_hdr));
+            msgs[k].msg_hdr.msg_name=&froms[k];
+            msgs[k].msg_hdr.msg_namelen=sizeof(froms[k]);
+            msgs[k].msg_hdr.msg_iov=&iovs[k];
+            msgs[k].msg_hdr.msg_iovlen=1;
+        }
+        int n=recvmmsg(fd,msgs,STATUS_BATCH,MSG_DONTWAIT,NULL);
+        if(n<0){
+            if(errno!=EAGAIN && errno!=EWOULDBLOCK && errno!=EINTR) perror("status recvmmsg");
+            break;
+        }
+        for(int k=0;k<n;k++){
+            char *m=bufs[k];
+            unsigned len=msgs[k].msg_len;
+            m[len]=0;
+            while(len>0 && (m[len-1]=='\n' || m[len-1]=='\r')) m[--len]=0;
+            int i=handle(&froms[k],m);
+            if(i>=0) changed|=(uint64_t)1<<i;
+        }
+        if(n<STATUS_BATCH) break;
+    }
+    for(int i=0;i<nmonitors;i++)
+        if((changed>>i)&1 && change_cb) change_cb(i);
+}
+
+int status_rx_init(int port,const struct sockaddr_in *addrs,int n,void (*on_change)(int idx)){
+    if(n<0 || n>MONITOR_MAX) return -1;
+    memcpy(monitors,addrs,n*sizeof(*addrs));
+    nmonitors=n;
+    change_cb=on_change;
+
+    sock=socket(AF_INET,SOCK_DGRAM|SOCK_NONBLOCK|SOCK_CLOEXEC,0);
+    if(sock<0){ perror("status socket"); return -1; }
+    int one=1;
+    setsockopt(sock,SOL_SOCKET,SO_REUSEADDR,&one,sizeof(one));
+
+    struct sockaddr_in a;
+    memset(&a,0,sizeof(a));
+    a.sin_family=AF_INET;
+    a.sin_port=htons(port);
+    a.sin_addr.s_addr=htonl(INADDR_ANY);
+    if(bind(sock,(struct sockaddr*)&a,sizeof(a))<0){ perror("status bind"); close(sock); sock=-1; return -1; }
+
+    return evloop_add(sock,EPOLLIN,on_readable,NULL);
+}
+
+int status_rx_add(const struct sockaddr_in *addr){
+    if(nmonitors>=MONITOR_MAX) return -1;
+    monitors[nmonitors]=*addr;
+    memset(&status[nmonitors],0,sizeof(status[nmonitors]));
+    return nmonitors++;
+}
+
+int status_rx_update(const struct sockaddr_in *addrs,int n){
+    if(n<0 || n>MONITOR_MAX) return -1;
+    for(int i=0;i<n;i++){
+        if(i<nmonitors && monitors[i].sin_addr.s_addr==addrs[i].sin_addr.s_addr && monitors[i].sin_port==addrs[i].sin_port)
+            continue;
+        monitors[i]=addrs[i];
+        memset(&status[i],0,sizeof(status[i]));     // สถานะของ address เดิมไม่เกี่ยวกับตัวใหม่
+    }
+    nmonitors=n;
+    return 0;
+}
+
+int status_rx_get(int idx,monitor_status_t *out){
+    if(idx<0 || idx>=nmonitors) return -1;
+    *out=status[idx];
+    return 0;
+}
+
+void status_rx_close(void){
+    if(sock<0) return;
+    evloop_del(sock);
+    close(sock);
+    sock=-1;
+}
@@ -0,0 +1,31 @@
+#ifndef STATUS_RX_H
+#define STATUS_RX_H
+
+#include <netinet/in.h>
+
+#ifndef STATUS_LEASE_MS
+#define STATUS_LEASE_MS 3000    // ไม่มี heartbeat ภายในเวลานี้ถือว่า monitor หลุด
+#endif
+#define STATUS_TEXT_MAX 48
+
+// datagram ที่ monitor ส่งมาที่ STATUS_PORT (ข้อความ ASCII/UTF-8 บรรทัดเดียว)
+//   "hb [lease_ms]"         heartbeat ยังอยู่ (ไม่ระบุ lease ใช้ STATUS_LEASE_MS)
+//   "st <code> [text]"      สถานะ: code 0 = ปกติ, >0 = ต้องการความสนใจ (LED กระพริบ)
+//                           text แสดงบรรทัดล่างของ OLED แทน "เชื่อมต่อ"
+// ขึ้นต้นด้วย "m<N> " ได้ เมื่อ monitor หลายตัวใช้ IP เดียวกัน ไม่ระบุจะนับเป็นตัวแรกที่ IP ตรง
+typedef struct {
+    int code;
+    char text[STATUS_TEXT_MAX];
+} monitor_status_t;
+
+// เปิด socket non-blocking ที่ port แล้วใส่ใน event loop
+// on_change(idx) ถูกเรียกหลังอ่านหมดแต่ละ batch สำหรับ monitor ที่สถานะเปลี่ยน
+int status_rx_init(int port,const struct sockaddr_in *addrs,int n,void (*on_change)(int idx));
+// เพิ่ม monitor ระหว่างทำงาน คืน index หรือ -1 ถ้าเต็ม
+int status_rx_add(const struct sockaddr_in *addr);
+// แทนรายการทั้งหมด (config ใหม่) ช่องที่ address เปลี่ยนล้างสถานะเดิม
+int status_rx_update(const struct sockaddr_in *addrs,int n);
+int status_rx_get(int idx,monitor_status_t *out);
+void status_rx_close(void);
+
+#endif
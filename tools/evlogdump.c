@@ -0,0 +1,34 @@
+// evlogdump: แปลง log เหตุการณ์แบบ binary (EVENT_LOG_FORMAT=bin) เป็นข้อความ
+//
+//   gcc -I. tools/evlogdump.c evlog.c -o tools/evlogdump -lpthread
+//   ./tools/evlogdump /var/log/monitor_control.evlog
+//
+// ไม่ระบุไฟล์อ่านจาก stdin (ใช้กับ tail -c +1 -f ได้)
+
+#include <stdio.h>
+#include <string.h>
+#include "evlog.h"
+
+int main(int argc,char **argv){
+    FILE *fp=stdin;
+    if(argc>1 && !(fp=fopen(argv[1],"rb"))){ perror(argv[1]); return 1; }
+
+    unsigned char hdr[8];
+    if(fread(hdr,1,sizeof(hdr),fp)!=sizeof(hdr) || memcmp(hdr,EVLOG_MAGIC,4)!=0){
+        fprintf(stderr,"not an event log\n");
+        return 1;
+    }
+    if(hdr[4]!=EVLOG_VERSION || hdr[5]!=sizeof(evlog_rec_t)){
+        fprintf(stderr,"unsupported event log version %u (record %u bytes)\n",hdr[4],hdr[5]);
+        return 1;
+    }
+
+    evlog_rec_t r;
+    char line[256];
+    while(fread(&r,sizeof(r),1,fp)==1){
+        evlog_format(line,sizeof(line),&r);
+        puts(line);
+    }
+    if(fp!=stdin) fclose(fp);
+    return 0;
+}
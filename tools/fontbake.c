@@ -0,0 +1,169 @@
+// fontbake: แปลงฟอนต์ TTF เป็น glyph atlas 1bpp สำหรับ compile เข้าโปรแกรม (font_atlas.h)
+//
+//   ./fontbake fonts/NotoSerifThai.ttf 24,18 0x20-0x7E,0x0E00-0x0E7F > font_atlas.h
+//
+// bitmap เรียงแบบ page ของ SSD1306 และ threshold (> 128) เหมือน glyph_cache.c
+// render_text จึงวาดจาก atlas ได้โดยไม่ต้อง link FreeType
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#define MAX_SIZES 8
+#define MAX_RANGES 16
+
+typedef struct { uint32_t first, last; } range_t;
+
+typedef struct {
+    uint32_t codepoint;
+    int left, top, advance, width, height;
+    uint32_t offset;
+} baked_t;
+
+static uint8_t *bits;
+static size_t bits_len, bits_cap;
+static baked_t *glyphs;
+static size_t nglyphs, glyphs_cap;
+
+static void usage(const char *prog){
+    fprintf(stderr,"usage: %s <font.ttf> <size[,size...]> <first-last[,first-last...]>\n",prog);
+    fprintf(stderr,"  e.g. %s fonts/NotoSerifThai.ttf 24,18 0x20-0x7E,0x0E00-0x0E7F > font_atlas.h\n",prog);
+    exit(2);
+}
+
+static void *grow(void *p,size_t *cap,size_t need,size_t elem){
+    if(need<=*cap) return p;
+    size_t n=*cap?*cap*2:256;
+    while(n<need) n*=2;
+    p=realloc(p,n*elem);
+    if(!p){ perror("realloc"); exit(1); }
+    *cap=n;
+    return p;
+}
+
+static int parse_sizes(char *arg,int *sizes){
+    int n=0;
+    for(char *tok=strtok(arg,",");tok;tok=strtok(NULL,",")){
+        if(n==MAX_SIZES){ fprintf(stderr,"too many sizes\n"); exit(2); }
+        sizes[n]=atoi(tok);
+        if(sizes[n]<=0 || sizes[n]>255){ fprintf(stderr,"bad size: %s\n",tok); exit(2); }
+        n++;
+    }
+    return n;
+}
+
+static int parse_ranges(char *arg,range_t *ranges){
+    int n=0;
+    for(char *tok=strtok(arg,",");tok;tok=strtok(NULL,",")){
+        if(n==MAX_RANGES){ fprintf(stderr,"too many ranges\n"); exit(2); }
+        char *dash=strchr(tok,'-');
+        unsigned long first=strtoul(tok,NULL,0);
+        unsigned long last=dash?strtoul(dash+1,NULL,0):first;
+        // เกิน U+10FFFF ไม่ใช่ Unicode และ last = 0xFFFFFFFF ทำให้ loop ของ uint32_t ไม่จบ
+        if(last<first || last>0x10FFFF){ fprintf(stderr,"bad range: %s\n",tok); exit(2); }
+        ranges[n].first=first;
+        ranges[n].last=last;
+        n++;
+    }
+    return n;
+}
+
+static int cmp_u32(const void *a,const void *b){
+    uint32_t x=*(const uint32_t*)a, y=*(const uint32_t*)b;
+    return x<y?-1:x>y;
+}
+
+static void bake_glyph(FT_Face face,uint32_t cp){
+    if(FT_Get_Char_Index(face,cp)==0) return;             // ไม่มีในฟอนต์
+    if(FT_Load_Char(face,cp,FT_LOAD_RENDER)) return;
+
+    FT_GlyphSlot g=face->glyph;
+    int w=g->bitmap.width, h=g->bitmap.rows;
+    if(w>255 || h>255){ fprintf(stderr,"glyph U+%04X too large, skipped\n",cp); return; }
+
+    size_t n=(size_t)w*((h+7)/8);
+    bits=grow(bits,&bits_cap,bits_len+n,1);
+    uint8_t *dst=bits+bits_len;
+    memset(dst,0,n);
+    for(int row=0;row<h;row++){
+        const uint8_t *src=&g->bitmap.buffer[row*g->bitmap.pitch];
+        uint8_t bit=1<<(row%8);
+        for(int col=0;col<w;col++){
+            if(src[col]>128) dst[(row/8)*w+col]|=bit;
+        }
+    }
+
+    glyphs=grow(glyphs,&glyphs_cap,nglyphs+1,sizeof(baked_t));
+    glyphs[nglyphs++]=(baked_t){ cp, g->bitmap_left, g->bitmap_top, (int)(g->advance.x>>6),
+                                 w, h, (uint32_t)bits_len };
+    bits_len+=n;
+}
+
+int main(int argc,char **argv){
+    if(argc!=4) usage(argv[0]);
+
+    int sizes[MAX_SIZES];
+    range_t ranges[MAX_RANGES];
+    int nsizes=parse_sizes(argv[2],sizes);
+    int nranges=parse_ranges(argv[3],ranges);
+
+    // รวม codepoint ทั้งหมด เรียงและตัดตัวซ้ำ (atlas ค้นด้วย binary search)
+    uint32_t *cps=NULL;
+    size_t ncp=0, cps_cap=0;
+    for(int r=0;r<nranges;r++){
+        for(uint32_t cp=ranges[r].first;cp<=ranges[r].last;cp++){
+            cps=grow(cps,&cps_cap,ncp+1,sizeof(uint32_t));
+            cps[ncp++]=cp;
+        }
+    }
+    qsort(cps,ncp,sizeof(uint32_t),cmp_u32);
+    size_t uniq=0;
+    for(size_t i=0;i<ncp;i++) if(uniq==0 || cps[i]!=cps[uniq-1]) cps[uniq++]=cps[i];
+    ncp=uniq;
+
+    FT_Library ft;
+    FT_Face face;
+    if(FT_Init_FreeType(&ft)){ fprintf(stderr,"Could not init FreeType\n"); return 1; }
+    if(FT_New_Face(ft,argv[1],0,&face)){ fprintf(stderr,"Failed to load font %s\n",argv[1]); return 1; }
+
+    size_t first[MAX_SIZES], count[MAX_SIZES];
+    for(int s=0;s<nsizes;s++){
+        FT_Set_Pixel_Sizes(face,0,sizes[s]);
+        first[s]=nglyphs;
+        for(size_t i=0;i<ncp;i++) bake_glyph(face,cps[i]);
+        count[s]=nglyphs-first[s];
+        fprintf(stderr,"size %d: %zu glyphs\n",sizes[s],count[s]);
+    }
+
+    printf("// generated by tools/fontbake from %s -- do not edit\n",argv[1]);
+    printf("// %zu glyphs, %zu bitmap bytes\n\n",nglyphs,bits_len);
+
+    printf("static const uint8_t font_atlas_bits[%zu] = {\n",bits_len?bits_len:1);
+    for(size_t i=0;i<bits_len;i++){
+        printf("%s0x%02X,",(i%16)==0?"    ":"",bits[i]);
+        if((i%16)==15 || i+1==bits_len) printf("\n");
+    }
+    if(!bits_len) printf("    0\n");
+    printf("};\n\n");
+
+    printf("static const font_atlas_glyph_t font_atlas_glyphs[%zu] = {\n",nglyphs?nglyphs:1);
+    for(size_t i=0;i<nglyphs;i++){
+        const baked_t *g=&glyphs[i];
+        printf("    { 0x%04X, %d, %d, %d, %d, %d, %u },\n",
+               g->codepoint,g->left,g->top,g->advance,g->width,g->height,g->offset);
+    }
+    if(!nglyphs) printf("    { 0 }\n");
+    printf("};\n\n");
+
+    printf("static const font_atlas_size_t font_atlas_sizes[%d] = {\n",nsizes);
+    for(int s=0;s<nsizes;s++) printf("    { %d, %zu, %zu },\n",sizes[s],count[s],first[s]);
+    printf("};\n");
+
+    FT_Done_Face(face);
+    FT_Done_FreeType(ft);
+    free(cps); free(bits); free(glyphs);
+    return 0;
+}
@@ -0,0 +1,132 @@
+// oledshow: แสดงภาพ PBM (P1/P4, 1 = pixel ติด) บน OLED ของ monitor_control ผ่าน DISPLAY_SOCKET
+//
+//   make tools
+//   ./build/oledshow [-s socket] [-x x] [-y y] [-p prio] [-t timeout_ms] [-d seconds] image.pbm
+//
+// ขอ region ขนาดเท่าภาพที่ (x,y) เขียน pixel ลง memfd ที่ได้มาแล้ว commit
+// ภาพอยู่จนกว่าโปรแกรมนี้จบ: -d วินาที (0 = จนกว่าจะกด Ctrl-C/kill) หรือ -t หมดเวลาก่อน
+// ไฟล์ "-" อ่านจาก stdin ตัวอย่าง client ของ oled_srv.h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "oled_srv.h"
+
+static volatile sig_atomic_t stop;
+static void on_signal(int sig){ (void)sig; stop=1; }
+
+// ตัวเลขใน header PBM (ข้าม whitespace และ comment)
+static int pbm_int(FILE *fp){
+    int c;
+    while((c=fgetc(fp))!=EOF){
+        if(c=='#') while((c=fgetc(fp))!=EOF && c!='\n');
+        else if(c>='0' && c<='9'){ ungetc(c,fp); break; }
+    }
+    int v;
+    return fscanf(fp,"%d",&v)==1 ? v : -1;
+}
+
+// อ่าน PBM เป็น bitmap ทีละแถว (1 byte ต่อ pixel)
+static uint8_t *read_pbm(FILE *fp,int *w,int *h){
+    char magic[3]={0};
+    if(fread(magic,1,2,fp)!=2 || magic[0]!='P' || (magic[1]!='1' && magic[1]!='4')) return NULL;
+    *w=pbm_int(fp);
+    *h=pbm_int(fp);
+    if(*w<=0 || *h<=0 || *w>OLED_MAX_WIDTH || *h>OLED_MAX_PAGES*8) return NULL;
+    uint8_t *px=calloc((size_t)*w**h,1);
+    if(!px) return NULL;
+
+    if(magic[1]=='4'){
+        fgetc(fp);                          // whitespace หนึ่งตัวหลัง header
+        int stride=(*w+7)/8;
+        uint8_t row[OLED_MAX_WIDTH/8];
+        for(int y=0;y<*h;y++){
+            if(fread(row,1,stride,fp)!=(size_t)stride){ free(px); return NULL; }
+            for(int x=0;x<*w;x++) px[y**w+x]=row[x/8]>>(7-x%8)&1;
+        }
+    }
+    else{
+        for(int i=0;i<*w**h;i++){
+            int c;
+            while((c=fgetc(fp))!=EOF && c!='0' && c!='1');
+            if(c==EOF){ free(px); return NULL; }
+            px[i]=c=='1';
+        }
+    }
+    return px;
+}
+
+// ส่งคำสั่งแล้วรอคำตอบ (fd != NULL รับ fd ที่แนบมาด้วย) คืน -1 ถ้าไม่ได้ "ok"
+static int request(int s,const char *cmd,char *resp,size_t len,int *fd){
+    if(send(s,cmd,strlen(cmd),0)<0){ perror("send"); return -1; }
+
+    union { char b[CMSG_SPACE(sizeof(int))]; struct cmsghdr align; } u;
+    struct iovec iov={ .iov_base=resp, .iov_len=len-1 };
+    struct msghdr m={ .msg_iov=&iov, .msg_iovlen=1, .msg_control=u.b, .msg_controllen=sizeof(u.b) };
+    ssize_t n=recvmsg(s,&m,MSG_CMSG_CLOEXEC);
+    if(n<=0){ fprintf(stderr,"%s: no reply\n",cmd); return -1; }
+    resp[n]=0;
+    struct cmsghdr *c=CMSG_FIRSTHDR(&m);
+    if(fd && c && c->cmsg_type==SCM_RIGHTS) memcpy(fd,CMSG_DATA(c),sizeof(int));
+    if(strncmp(resp,"ok",2)!=0){ fprintf(stderr,"%s: %s\n",cmd,resp); return -1; }
+    return 0;
+}
+
+int main(int argc,char **argv){
+    const char *path="/run/monitor_control.oled";
+    int x=0, y=0, prio=1, timeout_ms=0, seconds=0, opt;
+    while((opt=getopt(argc,argv,"s:x:y:p:t:d:"))!=-1){
+        switch(opt){
+        case 's': path=optarg; break;
+        case 'x': x=atoi(optarg); break;
+        case 'y': y=atoi(optarg); break;
+        case 'p': prio=atoi(optarg); break;
+        case 't': timeout_ms=atoi(optarg); break;
+        case 'd': seconds=atoi(optarg); break;
+        default:
+            fprintf(stderr,"usage: %s [-s socket] [-x x] [-y y] [-p prio] [-t timeout_ms] [-d seconds] image.pbm\n",argv[0]);
+            return 2;
+        }
+    }
+    if(optind>=argc){ fprintf(stderr,"%s: no image\n",argv[0]); return 2; }
+
+    FILE *fp=strcmp(argv[optind],"-")==0 ? stdin : fopen(argv[optind],"rb");
+    if(!fp){ perror(argv[optind]); return 1; }
+    int w, h;
+    uint8_t *px=read_pbm(fp,&w,&h);
+    if(fp!=stdin) fclose(fp);
+    if(!px){ fprintf(stderr,"%s: not a PBM image up to %dx%d\n",argv[optind],OLED_MAX_WIDTH,OLED_MAX_PAGES*8); return 1; }
+
+    struct sockaddr_un a={ .sun_family=AF_UNIX };
+    snprintf(a.sun_path,sizeof(a.sun_path),"%s",path);
+    int s=socket(AF_UNIX,SOCK_SEQPACKET|SOCK_CLOEXEC,0);
+    if(s<0 || connect(s,(struct sockaddr*)&a,sizeof(a))<0){ perror(path); return 1; }
+
+    char cmd[96], resp[96];
+    int mfd=-1, stride, slots;
+    size_t slot_size;
+    snprintf(cmd,sizeof(cmd),"claim %d %d %d %d %d %d",x,y,w,h,prio,timeout_ms);
+    if(request(s,cmd,resp,sizeof(resp),&mfd)<0) return 1;
+    if(mfd<0 || sscanf(resp,"ok %d %zu %d",&stride,&slot_size,&slots)!=3){ fprintf(stderr,"claim: bad reply %s\n",resp); return 1; }
+    uint8_t *shm=mmap(NULL,slot_size*slots,PROT_READ|PROT_WRITE,MAP_SHARED,mfd,0);
+    if(shm==MAP_FAILED){ perror("mmap"); return 1; }
+    close(mfd);
+
+    // layout page แบบ SSD1306 ลง slot 0 ตรงๆ
+    for(int yy=0;yy<h;yy++)
+        for(int xx=0;xx<w;xx++)
+            if(px[yy*w+xx]) shm[(yy/8)*stride+xx]|=1<<(yy%8);
+    if(request(s,"commit 0",resp,sizeof(resp),NULL)<0) return 1;
+
+    signal(SIGINT,on_signal);
+    signal(SIGTERM,on_signal);
+    if(seconds>0){ signal(SIGALRM,on_signal); alarm(seconds); }
+    while(!stop) pause();
+    close(s);               // คืน region ภาพหายจากจอ
+    return 0;
+}